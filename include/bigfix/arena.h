@@ -0,0 +1,166 @@
+/**
+ *  @file arena.h
+ *  @brief Monotonic arena for transient per-report parse allocations
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_ARENA_H_
+#define BIGFIX_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bf {
+
+/** default size of each arena block */
+const std::size_t kArenaBlock {1024 * 1024};
+
+/**
+ *  @brief Bump-pointer allocator whose memory is released all at once
+ *  @details Allocations are carved sequentially out of large blocks and are
+ *           never freed individually. reset() rewinds to the first block in
+ *           constant time but keeps every block, so a worker that parses one
+ *           report after another reuses the same memory without returning to
+ *           the heap once the arena has grown to fit the largest report.
+ */
+class Arena {
+ private:
+  /**
+   *  @brief Blocks owned by this arena, in allocation order
+   */
+  std::vector<std::unique_ptr<char[]>> blocks_;
+
+  /**
+   *  @brief Size of each block in blocks_
+   */
+  std::vector<std::size_t> sizes_;
+
+  /**
+   *  @brief Index of the block currently being carved
+   */
+  std::size_t block_ {0};
+
+  /**
+   *  @brief Bytes already used in the current block
+   */
+  std::size_t used_ {0};
+
+  /**
+   *  @brief Minimum size of newly allocated blocks
+   */
+  std::size_t block_size_;
+
+ public:
+  /**
+   *  @brief Construct an empty arena
+   *  @param block_size minimum size of each block
+   */
+  explicit Arena(std::size_t block_size = kArenaBlock);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   *  @brief Allocate uninitialized memory valid until the next reset()
+   *  @param bytes number of bytes
+   *  @param align required alignment, a power of two
+   *  @retval void* start of the allocation
+   */
+  void* allocate(std::size_t bytes,
+                 std::size_t align = alignof(std::max_align_t));
+
+  /**
+   *  @brief Release every allocation at once, keeping the blocks for reuse
+   */
+  void reset();
+
+  /**
+   *  @brief Total size of all blocks owned by this arena
+   *  @retval std::size_t capacity in bytes
+   */
+  std::size_t capacity() const;
+
+  /**
+   *  @brief Arena owned by the calling thread
+   *  @retval Arena arena reused by every report parsed on this thread
+   */
+  static Arena& local();
+};
+
+/**
+ *  @brief Standard allocator adaptor drawing from an Arena
+ *  @details deallocate() is a no-op; memory comes back when the arena is
+ *           reset, so containers using this allocator must not outlive it.
+ */
+template <typename T>
+class ArenaAllocator {
+ private:
+  template <typename U> friend class ArenaAllocator;
+
+  /**
+   *  @brief Arena providing the memory
+   */
+  Arena* arena_;
+
+ public:
+  typedef T value_type;
+
+  /**
+   *  @brief Construct an allocator drawing from an arena
+   *  @param arena arena providing the memory
+   */
+  explicit ArenaAllocator(Arena* arena) : arena_(arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other)  // NOLINT
+      : arena_(other.arena_) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T*, std::size_t) {}
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+};
+
+/** string whose characters live in an Arena */
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>
+    ArenaString;
+
+}  // namespace bf
+
+#endif  // BIGFIX_ARENA_H_
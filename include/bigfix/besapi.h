@@ -0,0 +1,133 @@
+/**
+ *  @file besapi.h
+ *  @brief Parser for BigFix REST API relevance query results
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_BESAPI_H_
+#define BIGFIX_BESAPI_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace bf {
+
+/** extension of saved REST API query responses */
+const std::string kXmlExt {".xml"};
+
+/**
+ *  @brief Incremental parser for /api/query XML responses
+ *  @details Expects the result of a plural relevance query returning one
+ *           (name, count) tuple per computer group, e.g.
+ *           (name of it, number of members of it) of bes computer groups.
+ *           Each complete Tuple element is converted as soon as it has been
+ *           fed in, reading the Answer elements in place; only a tuple that
+ *           straddles two calls to feed() is copied.
+ */
+class QueryParser {
+ private:
+  /**
+   *  @brief Unconsumed text of a tuple split across calls to feed()
+   */
+  std::string pending_;
+
+  /**
+   *  @brief Set once the closing Result element has been seen
+   */
+  bool complete_ {false};
+
+  /**
+   *  @brief Text of an Error element returned instead of a result
+   */
+  std::string error_;
+
+  /**
+   *  @brief Convert every complete tuple in a block of text
+   *  @param data start of the text
+   *  @param length length of the text
+   *  @param raw receives the count of each computer group
+   *  @retval std::size_t number of characters consumed; the remainder
+   *          belongs to an incomplete element
+   */
+  std::size_t scan(const char* data, std::size_t length,
+                   std::map<std::string, uint32_t>* raw);
+
+ public:
+  /**
+   *  @brief Parse the next block of the response
+   *  @param data start of the block
+   *  @param length length of the block
+   *  @param raw receives the count of each computer group
+   */
+  void feed(const char* data, std::size_t length,
+            std::map<std::string, uint32_t>* raw);
+
+  /**
+   *  @brief Whether the end of the query result has been reached
+   *  @retval bool false if the response was truncated or held an error
+   */
+  bool complete() const;
+
+  /**
+   *  @brief Accessor method for the error_ property
+   *  @retval std::string error reported by the server, empty if none
+   */
+  const std::string& error() const;
+};
+
+/**
+ *  @brief Whether a file holds a saved REST API response
+ *  @param filename name of a possibly compressed file
+ *  @retval bool true if the name ends in kXmlExt before any compression
+ *          suffix
+ */
+bool isQuery(const std::string& filename);
+
+/**
+ *  @brief Parse a complete, uncompressed REST API response held in memory
+ *  @param data start of the response
+ *  @param length length of the response
+ *  @param raw receives the count of each computer group
+ *  @retval bool false if the response was truncated or held an error
+ */
+bool parseQuery(const char* data, std::size_t length,
+                std::map<std::string, uint32_t>* raw);
+
+/**
+ *  @brief Stream a saved REST API response from a file
+ *  @param filename response file, possibly compressed
+ *  @param raw receives the count of each computer group
+ *  @retval bool false if the file could not be read, was truncated or held
+ *          an error
+ */
+bool loadQuery(const std::string& filename,
+               std::map<std::string, uint32_t>* raw);
+
+}  // namespace bf
+
+#endif  // BIGFIX_BESAPI_H_
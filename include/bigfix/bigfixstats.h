@@ -30,188 +30,341 @@
 #ifndef BIGFIX_BIGFIXSTATS_H_
 #define BIGFIX_BIGFIXSTATS_H_
 
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
+#include "bigfix/cache.h"
+#include "bigfix/catalog.h"
+#include "bigfix/columns.h"
+#include "bigfix/csv.h"
+#include "bigfix/endpoints.h"
+#include "bigfix/grouptable.h"
+#include "bigfix/join.h"
+#include "bigfix/output.h"
+#include "bigfix/partial.h"
+#include "bigfix/threadpool.h"
+#include "bigfix/tokenizer.h"
+#include "bigfix/view.h"
 
 /**
- *  @brief Model class for BigFix deployment information for a single computer
- *         group, following the model-view-controller software design pattern
- *  @details ComputerGroup contains all the operations and attributes associated
- *           with the deployment information for a single computer groups
+ *  @brief BigFix Statistics namespace for library-wide constants
  */
-class ComputerGroup {
- private:
-  /**
-   *  @brief Name of this computer group
-   */
-  std::string name_;
+namespace bf {
+  /** program name */
+  const std::string kProgramName {"bfstats"};
 
-  /**
-   *  @brief Number of computers currently in this computer group
-   */
-  uint32_t current_ {0};
+  /** program major revision number */
+  const uint8_t kMajorVersion {1};
 
-  /**
-   *  @brief Number of computers expected to be in this computer group
-   */
-  uint32_t target_ {0};
+  /** program minor revision number */
+  const uint8_t kMinorVersion {0};
 
-  /**
-   *  @brief Return the length of widest display element for this record
-   *  @retval uint8_t widest display element for this record
-   */
-  uint8_t widest() const;
+  /** delimiter for deployment targets file */
+  const std::string kDelim {","};
 
- public:
-  /**
-   *  @brief Construct an empty computer group
-   */
-  ComputerGroup();
+  /** extension of deployment status file */
+  const std::string kExt {".html"};
 
-  /**
-   *  @brief Construct a new computer group with the supplied name
-   *  @param name name of the computer group
-   */
-  explicit ComputerGroup(const std::string name);
+  /** format of the date field embedded in the deployment status file name */
+  const std::string kDate {"yyyymmdd"};
 
   /**
-   *  @brief Accessor method for the name_ property
-   *  @retval std::string Name of this computer group
+   *  @brief Kinds of deployment status file, told apart by extension
    */
-  std::string name() const;
+  enum class ReportFormat {
+    kHtml,   /**< Web Reports HTML export */
+    kQuery,  /**< REST API /api/query XML response */
+    kCsv     /**< Web Reports CSV export */
+  };
 
   /**
-   *  @brief Return formatted version of the computer group name
-   *  @retval output display formatted version of the computer group name
+   *  @brief Identify the kind of a deployment status file
+   *  @param filename name of the file, possibly compressed
+   *  @retval ReportFormat kind of report, kHtml unless recognized otherwise
    */
-  std::string formatted_name() const;
+  ReportFormat reportFormat(const std::string& filename);
 
   /**
-   *  @brief Accessor method for the current_ property
-   *  @retval Number of computers currently in this computer group
+   *  @brief Format a number into comma-separated groupings
+   *  @param number 32-bit unsigned integer to format
+   *  @retval std::string comma-separated thousands
    */
-  uint32_t current() const;
+  std::string format(const uint32_t number);
 
   /**
-   *  @brief Return formatted version of the current_ property
-   *  @retval output display formatted version of the number of computers 
-   *          currently in this computer group
+   *  @brief Extract the date embedded in a deployment status file name
+   *  @param filename name of the deployment status file
+   *  @retval std::string date in kDate format
    */
-  std::string formatted_current() const;
+  std::string date(const std::string& filename);
 
   /**
-   *  @brief Accessor method for the target_ property
-   *  @retval Number of computers expected to be in this computer group
+   *  @brief Escape text for inclusion in HTML output
+   *  @param text text to escape
+   *  @retval std::string text with HTML special characters replaced
    */
-  uint32_t target() const;
+  std::string escape(const std::string& text);
 
   /**
-   *  @brief Return formatted version of the target_ property
-   *  @retval output display formatted version of the number of computers
-   *          expected to be in this computer group
+   *  @brief Parse the value of a numeric command-line option
+   *  @param text decimal digits only, without sign or spaces
+   *  @param number receives the value
+   *  @retval bool false if the text is not a number or is out of range
    */
-  std::string formatted_target() const;
+  bool parseNumber(const std::string& text, std::size_t* number);
+}  // namespace bf
 
+/**
+ *  @brief Parsed inputs and worker threads kept by a daemon between requests
+ */
+struct WarmCache {
   /**
-   *  @brief Accessor method for the deployment percentage computed value
-   *  @retval uint8_t Percentage of computers deployed in this computer group
+   *  @brief Target tables, keyed by file identity
    */
-  uint8_t percent() const;
+  bf::LruCache<GroupTable> targets;
 
   /**
-   *  @brief Return formatted version of the deployment percentage computed
-   *         value
-   *  @retval output display formatted version of the Percentage of computers 
-   *          deployed in this computer group
+   *  @brief Raw counts of status reports, keyed by file identity and the
+   *         columns they were read with
    */
-  std::string formatted_percent() const;
+  bf::LruCache<std::map<std::string, uint32_t>> reports;
 
   /**
-   *  @brief Mutator method for the name_ property
-   *  @param name Name of this computer group
+   *  @brief Worker threads kept between requests, started by the first one
    */
-  void set_name(std::string name);
+  std::unique_ptr<bf::ThreadPool> pool;
 
   /**
-   *  @brief Mutator method for the current_ property
-   *  @param current Number of computers currently in this computer group
+   *  @brief Whether the workers in pool were asked to be pinned to CPUs
    */
-  void set_current(uint32_t current);
+  bool affinity {false};
 
   /**
-   *  @brief Mutator method for the target_ property
-   *  @param target Number of computers expected to be in this computer group
+   *  @brief Construct empty caches
+   *  @param entries maximum number of entries in each cache
    */
-  void set_target(uint32_t target);
+  explicit WarmCache(std::size_t entries) : targets(entries), reports(entries) {
+  }
 };
 
 /**
- *  @brief BigFix Statistics namespace for library-wide constants
+ *  @brief Run the program once with the given command-line arguments
+ *  @param args command-line arguments, without the program name
+ *  @param cache parsed inputs to reuse and extend, or nullptr for none
+ *  @retval int returns 0 upon successful completion, non-zero otherwise
  */
-namespace bf {
-  /** program name */
-  const std::string kProgramName {"bfstats"};
-
-  /** program major revision number */
-  const uint8_t kMajorVersion {1};
-
-  /** program minor revision number */
-  const uint8_t kMinorVersion {0};
-
-  /** text that indicates a line contains our records */
-  const std::string kRecord {"<tr>"};
-
-  /** text that indicates the start of a record */
-  const std::string kStart {"<td>"};
-
-  /** text that indicates the end of a record */
-  const std::string kEnd {"</td>"};
-
-  /** delimiter for deployment targets file */
-  const std::string kDelim {","};
-
-  /** extension of deployment status file */
-  const std::string kExt {".html"};
-
-  /** format of the date field embedded in the deployment status file name */
-  const std::string kDate {"yyyymmdd"};
-
-  /**
-   *  @brief Format a number into comma-separated groupings
-   *  @param number 32-bit unsigned integer to format
-   *  @retval std::string comma-separated thousands
-   */
-  std::string format(const uint32_t number);
-}  // namespace bf
+int run(std::vector<std::string> args, WarmCache* cache = nullptr);
 
 /**
  *  @brief Display command-line program usage and options
  */
 void usage();
 
+/**
+ *  @brief Display the raw counts of each source next to their sum
+ *  @param out destination of the table
+ *  @param files deployment status files the counts were read from
+ *  @param sources raw deployment counts of each file, in file order
+ *  @param raw summed raw deployment counts
+ *  @param html display an HTML table instead of Confluence markup
+ */
+void displaySources(bf::Output* out, const std::vector<std::string>& files,
+                    const std::vector<std::map<std::string, uint32_t>>& sources,
+                    const std::map<std::string, uint32_t>& raw, bool html);
+
 /**
  *  @brief Load target information from file
  *  @param filename input file containing deployment targets
  *  @param final collection of computer groups
+ *  @retval bool false if the file could not be read or had malformed lines,
+ *          which are reported with their line numbers
  */
-void loadTarget(std::string filename, std::vector<ComputerGroup>* final);
+bool loadTarget(std::string filename, GroupTable* final);
+
+/**
+ *  @brief Load target information, reusing a cached copy if unchanged
+ *  @param filename input file containing deployment targets
+ *  @param final collection of computer groups
+ *  @param cache parsed inputs of earlier requests, or nullptr for none
+ *  @retval bool false if the file could not be read or had malformed lines
+ */
+bool loadTarget(std::string filename, GroupTable* final, WarmCache* cache);
 
 /**
  *  @brief Load current information from file
  *  @param filename input file containing current status
  *  @param raw collection of computer groups with raw deployment counts
  *  @param final collection of computer groups with finalized counts
+ *  @param columns columns to read if the file is a CSV export
  */
 void loadCurrent(std::string filename, std::map<std::string, uint32_t>* raw,
-                 std::vector<ComputerGroup>* final);
+                 GroupTable* final,
+                 const bf::ReportColumns& columns = bf::ReportColumns());
+
+/**
+ *  @brief Extract raw deployment counts from one line of a report
+ *  @details Instantiated for bf::HtmlSchema and bf::UpperHtmlSchema
+ *  @param line start of the line of the deployment status file
+ *  @param length length of the line, excluding any newline
+ *  @param counts receives the count of each computer group on the line
+ */
+template <typename Schema = bf::HtmlSchema>
+void parseLine(const char* line, std::size_t length,
+               bf::CatalogCounts* counts);
+
+/**
+ *  @brief Extract raw deployment counts from an entire report held in memory
+ *  @param buffer contents of the deployment status file, possibly compressed
+ *  @param filename name of the deployment status file, for warnings
+ *  @param raw collection of computer groups with raw deployment counts
+ *  @param format kind of report held in the buffer
+ *  @param columns columns to read, if not the defaults
+ *  @retval bool false if the buffer could not be decompressed, a query
+ *          response was truncated or held an error, or a CSV export lacks
+ *          a named column
+ */
+bool parseBuffer(const std::string& buffer, const std::string& filename,
+                 std::map<std::string, uint32_t>* raw,
+                 bf::ReportFormat format = bf::ReportFormat::kHtml,
+                 const bf::ReportColumns& columns = bf::ReportColumns());
+
+/**
+ *  @brief Update computer groups with their raw deployment counts
+ *  @param raw collection of computer groups with raw deployment counts
+ *  @param final collection of computer groups with finalized counts
+ *  @param join if not null, receives the join of raw with final
+ */
+void updateCurrent(std::map<std::string, uint32_t>* raw, GroupTable* final,
+                   bf::JoinResult* join = nullptr);
+
+/**
+ *  @brief Load exact per-group counts from per-endpoint membership
+ *  @param endpoints per-endpoint membership
+ *  @param raw collection of computer groups with raw deployment counts
+ *  @param final collection of computer groups with finalized counts
+ *  @param join if not null, receives the join of raw with final
+ */
+void loadDistinct(const bf::EndpointSet& endpoints,
+                  std::map<std::string, uint32_t>* raw, GroupTable* final,
+                  bf::JoinResult* join = nullptr);
+
+/**
+ *  @brief Print how report groups matched the target table
+ *  @param out destination of the listing
+ *  @param join result of joining the report with the target table
+ *  @param final collection of computer groups the join was made against
+ */
+void printJoin(bf::Output* out, const bf::JoinResult& join,
+               GroupTable* final);
+
+/**
+ *  @brief Print the error bounds of approximate current counts
+ *  @param out destination of the note
+ *  @param endpoints sketched group memberships used for the counts
+ */
+void printApproximate(bf::Output* out, const bf::EndpointSet& endpoints);
+
+/**
+ *  @brief Load several status reports concurrently and sum their counts
+ *  @param files deployment status files, e.g. one per root server
+ *  @param pool worker threads to parse the files on
+ *  @param raw receives the summed count of each computer group
+ *  @param per_source receives the counts of each file, in file order
+ *  @param columns columns to read from CSV exports
+ *  @param groups expected number of distinct groups, e.g. of targets
+ *  @param cache parsed reports to reuse and extend, or nullptr for none
+ */
+void loadSources(const std::vector<std::string>& files, bf::ThreadPool* pool,
+                 std::map<std::string, uint32_t>* raw,
+                 std::vector<std::map<std::string, uint32_t>>* per_source,
+                 const bf::ReportColumns& columns = bf::ReportColumns(),
+                 std::size_t groups = 0, WarmCache* cache = nullptr);
+
+/**
+ *  @brief Gather the inputs of a sharded run into a partial aggregate
+ *  @param current_files status reports to sum, possibly none
+ *  @param endpoint_files per-endpoint exports to add, possibly none
+ *  @param merge_files saved partial aggregates to merge, possibly none
+ *  @param pool worker threads to parse reports and exports on
+ *  @param partial receives the combined counts
+ *  @param columns columns to read if a status report is a CSV export
+ *  @param budget memory limit for endpoint memberships, or zero for none
+ *  @retval bool false if any input could not be read, or if report counts
+ *          and endpoint memberships were mixed
+ */
+bool loadPartial(const std::vector<std::string>& current_files,
+                 const std::vector<std::string>& endpoint_files,
+                 const std::vector<std::string>& merge_files,
+                 bf::ThreadPool* pool, bf::Partial* partial,
+                 const bf::ReportColumns& columns = bf::ReportColumns(),
+                 std::size_t budget = 0);
+
+/**
+ *  @brief Load and display a batch of reports using the read engine
+ *  @param files deployment status files to process
+ *  @param depth number of file reads kept in flight
+ *  @param pool worker threads to parse the reports on
+ *  @param targets collection of computer groups with target counts
+ *  @param out destination of the tables
+ *  @param html display HTML tables instead of Confluence markup
+ *  @param columns columns to read, if not the defaults
+ *  @param view computer groups and rows to display
+ */
+void loadBatch(const std::vector<std::string>& files, std::size_t depth,
+               bf::ThreadPool* pool, const GroupTable& targets,
+               bf::Output* out, bool html,
+               const bf::ReportColumns& columns = bf::ReportColumns(),
+               const bf::View& view = bf::View());
+
+/**
+ *  @brief Compare read engine throughput with the stream path
+ *  @param files deployment status files to read
+ *  @param depth number of file reads kept in flight
+ */
+void benchRead(const std::vector<std::string>& files, std::size_t depth);
+
+/**
+ *  @brief Compare shared and per-thread group counters across group counts
+ *  @param pool worker threads, one contending task per worker
+ */
+void benchCounters(bf::ThreadPool* pool);
+
+/**
+ *  @brief Print the instrumentation of each pool worker
+ *  @param pool worker threads used by the run
+ */
+void printStats(bf::ThreadPool* pool);
 
 /**
  *  @brief Display output for pasting into Confluence
+ *  @param out destination of the tables
+ *  @param filename name of the file containing raw deployment counts
+ *  @param raw collection of raw computer group deployment counts
+ *  @param final collection of computer groups with finalized counts
+ *  @param endpoints per-endpoint membership used for exact distinct totals,
+ *         or nullptr to sum the counts
+ *  @param view computer groups and rows to display
+ */
+void display(bf::Output* out, std::string filename,
+             std::map<std::string, uint32_t>* raw, GroupTable* final,
+             const bf::EndpointSet* endpoints = nullptr,
+             const bf::View& view = bf::View());
+
+/**
+ *  @brief Display output as HTML tables
+ *  @param out destination of the tables
  *  @param filename name of the file containing raw deployment counts
  *  @param raw collection of raw computer group deployment counts
  *  @param final collection of computer groups with finalized counts
+ *  @param endpoints per-endpoint membership used for exact distinct totals,
+ *         or nullptr to sum the counts
+ *  @param view computer groups and rows to display
  */
-void display(std::string filename, std::map<std::string, uint32_t>* raw,
-             std::vector<ComputerGroup>* final);
+void displayHtml(bf::Output* out, std::string filename,
+                 std::map<std::string, uint32_t>* raw, GroupTable* final,
+                 const bf::EndpointSet* endpoints = nullptr,
+                 const bf::View& view = bf::View());
 
 #endif  // BIGFIX_BIGFIXSTATS_H_
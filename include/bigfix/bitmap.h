@@ -0,0 +1,171 @@
+/**
+ *  @file bitmap.h
+ *  @brief Compressed bitmap of 32-bit computer identifiers
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_BITMAP_H_
+#define BIGFIX_BITMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bf {
+
+/**
+ *  @brief Set of 32-bit integers stored as a roaring-style compressed bitmap
+ *  @details Values are partitioned by their upper 16 bits. Each partition is
+ *           a sorted array of lower halves while it holds at most
+ *           kArrayLimit values and a fixed 8 KiB bitset once it grows beyond
+ *           that, so sparse and dense sets of computer IDs both stay compact
+ *           and set operations work a whole partition at a time.
+ */
+class Bitmap {
+ public:
+  /** largest number of values kept in an array partition */
+  static const uint32_t kArrayLimit {4096};
+
+  /** number of 64-bit words in a bitset partition */
+  static const std::size_t kWords {1024};
+
+ private:
+  /**
+   *  @brief Values sharing the same upper 16 bits
+   */
+  struct Container {
+    /** sorted lower 16 bits, used while the container is an array */
+    std::vector<uint16_t> array;
+    /** bitset of lower 16 bits, used once the container is dense */
+    std::vector<uint64_t> bits;
+    /** number of values in this container */
+    uint32_t cardinality {0};
+
+    bool dense() const { return !bits.empty(); }
+    void to_bitset();
+    void to_array();
+    bool add(uint16_t low);
+    bool contains(uint16_t low) const;
+  };
+
+  /**
+   *  @brief Upper 16 bits of each container, sorted ascending
+   */
+  std::vector<uint16_t> keys_;
+
+  /**
+   *  @brief Containers matching keys_
+   */
+  std::vector<Container> containers_;
+
+  /**
+   *  @brief Set operations implemented by combine()
+   */
+  enum Op { kOr, kAnd, kAndNot };
+
+  /**
+   *  @brief Combine two containers holding the same upper 16 bits
+   *  @param a left operand
+   *  @param b right operand
+   *  @param op set operation
+   *  @retval Container result, possibly empty
+   */
+  static Container merge(const Container& a, const Container& b, Op op);
+
+  /**
+   *  @brief Combine this bitmap with another, container by container
+   *  @param other bitmap to combine with
+   *  @param op set operation
+   */
+  void combine(const Bitmap& other, Op op);
+
+ public:
+  /**
+   *  @brief Add a value to the set
+   *  @param value value to add
+   *  @retval bool true if the value was not already present
+   */
+  bool add(uint32_t value);
+
+  /**
+   *  @brief Whether a value is in the set
+   *  @param value value to test
+   *  @retval bool true if present
+   */
+  bool contains(uint32_t value) const;
+
+  /**
+   *  @brief Number of values in the set
+   *  @retval uint64_t cardinality
+   */
+  uint64_t cardinality() const;
+
+  /**
+   *  @brief Every value in the set
+   *  @param values receives the values in ascending order, replacing any
+   *         previous contents
+   */
+  void values(std::vector<uint32_t>* values) const;
+
+  /**
+   *  @brief Size of the set in memory
+   *  @retval std::size_t approximate number of bytes used by the containers
+   */
+  std::size_t bytes() const;
+
+  /**
+   *  @brief Replace this set with its union with another
+   *  @param other set to merge in
+   *  @retval Bitmap this set
+   */
+  Bitmap& operator|=(const Bitmap& other);
+
+  /**
+   *  @brief Replace this set with its intersection with another
+   *  @param other set to intersect with
+   *  @retval Bitmap this set
+   */
+  Bitmap& operator&=(const Bitmap& other);
+
+  /**
+   *  @brief Remove every value that is also in another set
+   *  @param other set of values to remove
+   *  @retval Bitmap this set
+   */
+  Bitmap& operator-=(const Bitmap& other);
+
+  /**
+   *  @brief Size of the intersection of two sets without building it
+   *  @param a first set
+   *  @param b second set
+   *  @retval uint64_t number of values in both sets
+   */
+  static uint64_t and_cardinality(const Bitmap& a, const Bitmap& b);
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_BITMAP_H_
@@ -0,0 +1,133 @@
+/**
+ *  @file cache.h
+ *  @brief Least-recently-used cache of parsed input files
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BIGFIX_CACHE_H_
+#define BIGFIX_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace bf {
+
+/** default number of entries kept by each daemon cache */
+const std::size_t kCacheEntries {64};
+
+/**
+ *  @brief Keeps the most recently used values up to a fixed number of entries
+ *  @details Entries live in a list ordered from most to least recently used,
+ *           indexed by a hash map, so lookups, insertions and evictions are
+ *           all constant time. Values are shared, so an entry evicted while
+ *           a caller still holds it stays valid for that caller.
+ */
+template <typename T>
+class LruCache {
+ private:
+  typedef std::pair<std::string, std::shared_ptr<const T>> Entry;
+
+  /**
+   *  @brief Maximum number of entries
+   */
+  std::size_t capacity_;
+
+  /**
+   *  @brief Entries, most recently used first
+   */
+  std::list<Entry> entries_;
+
+  /**
+   *  @brief Position of each entry in entries_, indexed by key
+   */
+  std::unordered_map<std::string, typename std::list<Entry>::iterator> index_;
+
+ public:
+  /**
+   *  @brief Construct an empty cache
+   *  @param capacity maximum number of entries, at least one
+   */
+  explicit LruCache(std::size_t capacity = kCacheEntries)
+      : capacity_(capacity > 0 ? capacity : 1) {
+  }
+
+  /**
+   *  @brief Look up a value and mark it as most recently used
+   *  @param key key the value was stored under
+   *  @retval std::shared_ptr<const T> cached value, or nullptr if absent
+   */
+  std::shared_ptr<const T> find(const std::string& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+  }
+
+  /**
+   *  @brief Store a value, evicting the least recently used entry if full
+   *  @param key key to store the value under
+   *  @param value value to store
+   */
+  void insert(const std::string& key, T value) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      entries_.erase(it->second);
+      index_.erase(it);
+    } else if (entries_.size() == capacity_) {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+    entries_.emplace_front(key, std::make_shared<const T>(std::move(value)));
+    index_[key] = entries_.begin();
+  }
+
+  /**
+   *  @brief Number of entries
+   *  @retval std::size_t number of cached values
+   */
+  std::size_t size() const {
+    return entries_.size();
+  }
+};
+
+/**
+ *  @brief Build a cache key identifying the current contents of a file
+ *  @details The key combines the canonical path with the modification time
+ *           and size, so a rewritten file never matches a stale entry
+ *  @param filename file to identify
+ *  @param key receives the key
+ *  @retval bool false if the file does not exist
+ */
+bool fileKey(const std::string& filename, std::string* key);
+
+}  // namespace bf
+
+#endif  // BIGFIX_CACHE_H_
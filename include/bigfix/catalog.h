@@ -0,0 +1,237 @@
+/**
+ *  @file catalog.h
+ *  @brief Compile-time perfect hash of the known computer group catalogue
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_CATALOG_H_
+#define BIGFIX_CATALOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "bigfix/catalogdata.h"
+
+namespace bf {
+
+/** FNV-1a offset basis used to hash group names */
+const uint64_t kCatalogOffset {14695981039346656037ULL};
+
+/** FNV-1a prime used to hash group names */
+const uint64_t kCatalogPrime {1099511628211ULL};
+
+/** returned by catalogFind() for names outside the catalogue */
+const int kNotInCatalog {-1};
+
+/**
+ *  @brief FNV-1a hash of a group name, usable in constant expressions
+ *  @param data first character of the name
+ *  @param length number of characters in the name
+ *  @param hash hash of the characters before data
+ *  @retval uint64_t hash of the name
+ */
+constexpr uint64_t catalogHash(const char* data, std::size_t length,
+                               uint64_t hash = kCatalogOffset) {
+  return length == 0 ? hash
+                     : catalogHash(data + 1, length - 1,
+                                   (hash ^ static_cast<unsigned char>(*data)) *
+                                       kCatalogPrime);
+}
+
+/**
+ *  @brief One xor-shift step of catalogMix()
+ *  @param x value to fold
+ *  @param shift number of bits to shift by
+ *  @retval uint64_t x with its high bits folded into its low bits
+ */
+constexpr uint64_t catalogFold(uint64_t x, int shift) {
+  return x ^ (x >> shift);
+}
+
+/**
+ *  @brief Scramble a hash so that every bit depends on every input bit
+ *  @param x value to scramble
+ *  @retval uint64_t scrambled value, the SplitMix64 finalizer of x
+ */
+constexpr uint64_t catalogMix(uint64_t x) {
+  return catalogFold(catalogFold(catalogFold(x, 30) * 0xbf58476d1ce4e5b9ULL,
+                                 27) * 0x94d049bb133111ebULL, 31);
+}
+
+/**
+ *  @brief First level of the perfect hash: the bucket holding a name
+ *  @param hash catalogHash() of the name
+ *  @param buckets number of buckets, a power of two
+ *  @retval std::size_t bucket index
+ */
+constexpr std::size_t catalogBucket(uint64_t hash, std::size_t buckets) {
+  return static_cast<std::size_t>(catalogMix(hash) & (buckets - 1));
+}
+
+/**
+ *  @brief Second level of the perfect hash: the slot chosen by a seed
+ *  @param hash catalogHash() of the name
+ *  @param seed displacement seed of the name's bucket
+ *  @param slots number of slots, a power of two
+ *  @retval std::size_t slot index
+ */
+constexpr std::size_t catalogSlot(uint64_t hash, uint64_t seed,
+                                  std::size_t slots) {
+  return static_cast<std::size_t>(catalogMix(hash ^ seed) & (slots - 1));
+}
+
+/**
+ *  @brief Compare two character ranges in a constant expression
+ *  @param a first range
+ *  @param b second range
+ *  @param length number of characters to compare
+ *  @retval bool true if the ranges are equal
+ */
+constexpr bool catalogEqual(const char* a, const char* b, std::size_t length) {
+  return length == 0 || (*a == *b && catalogEqual(a + 1, b + 1, length - 1));
+}
+
+/**
+ *  @brief Confirm that the group in a name's slot really is that name
+ *  @param group group stored in the slot, or kNotInCatalog if it is empty
+ *  @param data first character of the name
+ *  @param length number of characters in the name
+ *  @retval int group, or kNotInCatalog if the name is a different one
+ */
+constexpr int catalogCheck(int group, const char* data, std::size_t length) {
+  return group != kNotInCatalog && catalog::kLengths[group] == length &&
+                 catalogEqual(catalog::kNames[group], data, length)
+             ? group
+             : kNotInCatalog;
+}
+
+/**
+ *  @brief Find the group in the slot selected by a name's hash
+ *  @param hash catalogHash() of the name
+ *  @param data first character of the name
+ *  @param length number of characters in the name
+ *  @retval int index into catalog::kNames, or kNotInCatalog
+ */
+constexpr int catalogLookup(uint64_t hash, const char* data,
+                            std::size_t length) {
+  return catalogCheck(
+      catalog::kSlotGroup[catalogSlot(
+          hash, catalog::kSeeds[catalogBucket(hash, catalog::kBuckets)],
+          catalog::kSlots)],
+      data, length);
+}
+
+/**
+ *  @brief Index of a group in the catalogue
+ *  @details One hash of the name, one seed and one slot lookup, then a single
+ *           comparison; there is no probing
+ *  @param data first character of the name
+ *  @param length number of characters in the name
+ *  @retval int index into catalog::kNames, or kNotInCatalog
+ */
+constexpr int catalogFind(const char* data, std::size_t length) {
+  return catalogLookup(catalogHash(data, length), data, length);
+}
+
+/**
+ *  @brief Whether every catalogue name from first to last finds itself
+ *  @details Splits the range in halves to keep constexpr recursion shallow
+ *  @param first index of the first name to check
+ *  @param last index one past the last name to check
+ *  @retval bool true if the generated tables are consistent
+ */
+constexpr bool catalogValid(std::size_t first, std::size_t last) {
+  return last - first == 0 ? true
+         : last - first == 1
+             ? catalogFind(catalog::kNames[first],
+                           catalog::kLengths[first]) ==
+                   static_cast<int>(first)
+             : catalogValid(first, first + (last - first) / 2) &&
+                   catalogValid(first + (last - first) / 2, last);
+}
+
+/**
+ *  @brief Counts parsed from one report, keyed by catalogue index when known
+ *  @details Known groups are counted in an array and copied into the raw
+ *           map once the report has been parsed; other groups go straight
+ *           into the map. As with std::map::emplace, the first count seen
+ *           for a group is the one kept.
+ */
+class CatalogCounts {
+ private:
+  /**
+   *  @brief Map receiving every count
+   */
+  std::map<std::string, uint32_t>* raw_;
+
+  /**
+   *  @brief Count of each catalogue group
+   */
+  std::vector<uint32_t> counts_;
+
+  /**
+   *  @brief Whether each catalogue group has been seen
+   */
+  std::vector<char> seen_;
+
+ public:
+  /**
+   *  @brief Start counting a report
+   *  @param raw map receiving every count
+   */
+  explicit CatalogCounts(std::map<std::string, uint32_t>* raw);
+
+  /**
+   *  @brief Record the count of a group unless it already has one
+   *  @param name first character of the group name
+   *  @param length number of characters in the name
+   *  @param count number of computers in the group
+   */
+  void add(const char* name, std::size_t length, uint32_t count);
+
+  /**
+   *  @brief Copy the counts of catalogue groups into the raw map
+   */
+  void flush();
+};
+
+/**
+ *  @brief Generate catalogdata.h for a set of group names
+ *  @details Searches for a displacement seed per bucket so that every name
+ *           lands in a slot of its own, doubling the slots if necessary
+ *  @param names distinct group names, in catalogue order
+ *  @param source file the names were read from, noted in the header
+ *  @param filename header file to write
+ *  @retval bool false if the file could not be written
+ */
+bool writeCatalog(const std::vector<std::string>& names,
+                  const std::string& source, const std::string& filename);
+
+}  // namespace bf
+
+#endif  // BIGFIX_CATALOG_H_
@@ -0,0 +1,53 @@
+/**
+ *  @file catalogdata.h
+ *  @brief Perfect hash tables of the computer group catalogue
+ *  @details Generated by bfstats --emit-catalog from data/catalog.csv;
+ *           regenerate with "make catalog"
+ */
+
+#ifndef BIGFIX_CATALOGDATA_H_
+#define BIGFIX_CATALOGDATA_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bf {
+namespace catalog {
+
+/** number of groups in the catalogue */
+constexpr std::size_t kGroups {5};
+
+/** number of first-level buckets, a power of two */
+constexpr std::size_t kBuckets {2};
+
+/** number of slots, a power of two */
+constexpr std::size_t kSlots {8};
+
+/** displacement seed of each bucket */
+constexpr uint64_t kSeeds[kBuckets] {
+  1, 2,
+};
+
+/** group in each slot, -1 if the slot is empty */
+constexpr int kSlotGroup[kSlots] {
+  2, 1, -1, 4, 3, -1, -1, 0,
+};
+
+/** name of each group */
+constexpr const char* kNames[] {
+  "OS",
+  "MBDA",
+  "CBS",
+  "HCHB",
+  "Servers",
+};
+
+/** length of each name */
+constexpr std::size_t kLengths[] {
+  2, 4, 3, 4, 7,
+};
+
+}  // namespace catalog
+}  // namespace bf
+
+#endif  // BIGFIX_CATALOGDATA_H_
@@ -0,0 +1,164 @@
+/**
+ *  @file columns.h
+ *  @brief Selection of the group and count columns of a report table
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_COLUMNS_H_
+#define BIGFIX_COLUMNS_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "bigfix/tokenizer.h"
+
+namespace bf {
+
+/**
+ *  @brief Columns of a report holding the computer group and its count
+ *  @details Each column is given either by its header, matched by name
+ *           ignoring case and surrounding blanks, or by its position
+ *           counting from 1. When neither is given, CSV exports use their
+ *           first two columns and HTML reports pair consecutive cells.
+ */
+struct ReportColumns {
+  /** header or position of the computer group column, empty for default */
+  std::string group;
+  /** header or position of the computer count column, empty for default */
+  std::string count;
+};
+
+/**
+ *  @brief Read a column given by position
+ *  @param column column as given on the command line
+ *  @param index receives the zero-based index if column is a position
+ *  @retval bool true if column is a positive decimal number
+ */
+bool columnIndex(const std::string& column, std::size_t* index);
+
+/**
+ *  @brief Whether a header cell names a column, ignoring case and blanks
+ *  @param data start of the header cell
+ *  @param length length of the header cell
+ *  @param name column name to match
+ *  @retval bool true if they match
+ */
+bool columnMatches(const char* data, std::size_t length,
+                   const std::string& name);
+
+/**
+ *  @brief Positions of the selected columns within one HTML report
+ *  @details Columns given by position are known from the start. Columns
+ *           given by name are located in the first header row, and rows
+ *           before it are ignored. Each later header row is compared with
+ *           the one before, and a warning is printed if the layout changed
+ *           or a named column went missing, since the counts that follow
+ *           may then come from the wrong cells.
+ */
+class ColumnLayout {
+ private:
+  /**
+   *  @brief Columns requested by the user
+   */
+  const ReportColumns& columns_;
+
+  /**
+   *  @brief Report being parsed, for warnings
+   */
+  std::string filename_;
+
+  /**
+   *  @brief Index of the computer group column
+   */
+  std::size_t group_ {0};
+
+  /**
+   *  @brief Index of the computer count column
+   */
+  std::size_t count_ {1};
+
+  /**
+   *  @brief Whether every named column has been located
+   */
+  bool ready_ {true};
+
+  /**
+   *  @brief Header cells of the most recent header row
+   */
+  std::vector<std::string> header_;
+
+  /**
+   *  @brief Locate one named column in a header row
+   *  @param name column name
+   *  @param names header cells
+   *  @param index receives the index of the column if found
+   *  @retval bool false if no header cell matches name
+   */
+  bool locate(const std::string& name, const std::vector<std::string>& names,
+              std::size_t* index);
+
+ public:
+  /**
+   *  @brief Resolve the columns given by position
+   *  @param columns columns requested by the user
+   *  @param filename report being parsed, for warnings
+   */
+  ColumnLayout(const ReportColumns& columns, const std::string& filename);
+
+  /**
+   *  @brief Whether any column was requested
+   *  @retval bool false if consecutive cells should be paired instead
+   */
+  bool selected() const;
+
+  /**
+   *  @brief Whether rows can be read, i.e. every named column was located
+   *  @retval bool true once the columns are known
+   */
+  bool ready() const;
+
+  /**
+   *  @brief Accessor method for the group_ property
+   *  @retval std::size_t index of the computer group column
+   */
+  std::size_t group() const;
+
+  /**
+   *  @brief Accessor method for the count_ property
+   *  @retval std::size_t index of the computer count column
+   */
+  std::size_t count() const;
+
+  /**
+   *  @brief Take note of a header row
+   *  @param cells header cells of the row, in order
+   */
+  void header(const std::vector<Cell>& cells);
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_COLUMNS_H_
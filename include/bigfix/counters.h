@@ -0,0 +1,250 @@
+/**
+ *  @file counters.h
+ *  @brief Per-group counters shared by parallel parsing threads
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_COUNTERS_H_
+#define BIGFIX_COUNTERS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bf {
+
+/**
+ *  @brief Fixed-capacity hash table of group counters safe for concurrent use
+ *  @details Open addressing with linear probing over slots holding the
+ *           name's hash, the interned name and an atomic counter. A new name
+ *           claims a slot with a single compare-and-swap on its hash and
+ *           publishes its name with a release store; lookups and increments
+ *           never lock. Threads that race to insert the same name briefly
+ *           wait for the winner to publish it. The table never grows: add()
+ *           reports when it is full so the caller can fall back.
+ */
+class CounterTable {
+ private:
+  /**
+   *  @brief One entry of the table
+   */
+  struct Slot {
+    /** hash of the name, 0 while the slot is free */
+    std::atomic<uint64_t> hash {0};
+    /** name, published after the hash has been claimed */
+    std::atomic<const std::string*> name {nullptr};
+    /** number of computers counted for the name */
+    std::atomic<uint64_t> count {0};
+  };
+
+  /**
+   *  @brief Slot array, a power of two in size
+   */
+  std::unique_ptr<Slot[]> slots_;
+
+  /**
+   *  @brief Number of slots less one, for masking probe positions
+   */
+  std::size_t mask_;
+
+  /**
+   *  @brief Number of names inserted before the table counts as full
+   */
+  std::size_t limit_;
+
+  /**
+   *  @brief Number of occupied slots
+   */
+  std::atomic<std::size_t> size_ {0};
+
+ public:
+  /**
+   *  @brief Construct an empty table
+   *  @param capacity number of distinct names the table must hold; twice
+   *         as many slots are allocated to keep probe sequences short
+   */
+  explicit CounterTable(std::size_t capacity);
+
+  /**
+   *  @brief Free the interned names
+   */
+  ~CounterTable();
+
+  CounterTable(const CounterTable&) = delete;
+  CounterTable& operator=(const CounterTable&) = delete;
+
+  /**
+   *  @brief Add to the counter of a name, inserting the name if it is new
+   *  @param name group name
+   *  @param count amount to add
+   *  @retval bool false if the name is new and the table is full
+   */
+  bool add(const std::string& name, uint64_t count);
+
+  /**
+   *  @brief Current value of a counter
+   *  @param name group name
+   *  @retval uint64_t counter value, 0 if the name is not in the table
+   */
+  uint64_t find(const std::string& name) const;
+
+  /**
+   *  @brief Number of distinct names in the table
+   *  @retval std::size_t number of names
+   */
+  std::size_t size() const;
+
+  /**
+   *  @brief Copy every counter into a map, once all updates have finished
+   *  @param counts receives each name's counter, added to any existing value
+   */
+  void collect(std::map<std::string, uint64_t>* counts) const;
+};
+
+/**
+ *  @brief Ways of combining counts from several threads
+ */
+enum class CounterStrategy {
+  kShared,  /**< one CounterTable updated by every thread */
+  kLocal    /**< a private map per thread, merged at the end */
+};
+
+/**
+ *  @brief Bytes one name takes in a worker's private map, counting the hash
+ *         node, its bucket and the inline string
+ */
+const std::size_t kLocalCounterBytes {64};
+
+/**
+ *  @brief Per-core cache size assumed when the system does not report one
+ */
+const std::size_t kDefaultCoreCache {1 << 20};
+
+/**
+ *  @brief Pick the faster strategy for a number of workers and groups
+ *  @details A single worker never contends, so it always counts privately.
+ *           With more, private maps win while each one stays in its core's
+ *           own cache and merging them is cheap; once a map outgrows that
+ *           cache every worker misses on its own copy of every name, and
+ *           the atomic increments of one shared table cost less. The cache
+ *           size is read from the system at run time. See --bench-counters
+ *  @param workers number of threads that will add counts
+ *  @param groups expected number of distinct groups
+ *  @retval CounterStrategy kShared if several workers would each hold a map
+ *          larger than a core's cache
+ */
+CounterStrategy chooseStrategy(std::size_t workers, std::size_t groups);
+
+/**
+ *  @brief Per-group totals accumulated by a fixed set of worker threads
+ *  @details Each worker passes its own index to add(), so the private-map
+ *           strategy needs no synchronization at all; the shared strategy
+ *           spills into a locked map only if the table fills up.
+ */
+class GroupCounters {
+ private:
+  /**
+   *  @brief Private map of one worker, padded so that neighbouring workers
+   *         never write to the same cache line
+   */
+  struct Local {
+    std::unordered_map<std::string, uint64_t> counts;
+    char padding[64];
+  };
+
+  /**
+   *  @brief Strategy in use
+   */
+  CounterStrategy strategy_;
+
+  /**
+   *  @brief Table shared by all workers with the kShared strategy
+   */
+  CounterTable shared_;
+
+  /**
+   *  @brief Counts that did not fit in shared_
+   */
+  std::map<std::string, uint64_t> overflow_;
+
+  /**
+   *  @brief Guards overflow_
+   */
+  std::mutex overflow_mutex_;
+
+  /**
+   *  @brief One map per worker with the kLocal strategy
+   */
+  std::vector<Local> local_;
+
+ public:
+  /**
+   *  @brief Construct empty counters
+   *  @param workers number of threads that will call add()
+   *  @param groups expected number of distinct groups
+   *  @param strategy strategy to use, chosen from groups if not given
+   */
+  GroupCounters(std::size_t workers, std::size_t groups,
+                CounterStrategy strategy);
+
+  /**
+   *  @brief Construct empty counters using the faster strategy for the
+   *         number of workers and groups
+   *  @param workers number of threads that will call add()
+   *  @param groups expected number of distinct groups
+   */
+  GroupCounters(std::size_t workers, std::size_t groups);
+
+  /**
+   *  @brief Add to a group's total
+   *  @param worker index of the calling thread, less than workers
+   *  @param name group name
+   *  @param count amount to add
+   */
+  void add(std::size_t worker, const std::string& name, uint64_t count);
+
+  /**
+   *  @brief Combine all totals, once every worker has finished
+   *  @param counts receives the total of each group
+   */
+  void collect(std::map<std::string, uint64_t>* counts);
+
+  /**
+   *  @brief Accessor method for the strategy_ property
+   *  @retval CounterStrategy strategy in use
+   */
+  CounterStrategy strategy() const;
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_COUNTERS_H_
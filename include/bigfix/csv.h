@@ -0,0 +1,82 @@
+/**
+ *  @file csv.h
+ *  @brief Parser for Web Reports CSV exports
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_CSV_H_
+#define BIGFIX_CSV_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include "bigfix/columns.h"
+
+namespace bf {
+
+/** extension of Web Reports CSV exports */
+const std::string kCsvExt {".csv"};
+
+/**
+ *  @brief Whether a file holds a CSV export
+ *  @param filename name of a possibly compressed file
+ *  @retval bool true if the name ends in kCsvExt before any compression
+ *          suffix
+ */
+bool isCsv(const std::string& filename);
+
+/**
+ *  @brief Parse an entire, uncompressed CSV export held in memory
+ *  @details Fields follow RFC 4180: quoted fields may contain delimiters,
+ *           line breaks and doubled quotes. Sixty-four bytes are classified
+ *           at a time into bitmasks of quotes, commas and newlines; quoted
+ *           regions are found with a prefix XOR over the quote mask, so
+ *           field boundaries are located without a branch per character.
+ *           Counts may carry thousands separators.
+ *  @param data start of the export
+ *  @param length length of the export
+ *  @param columns columns to read
+ *  @param raw receives the count of each computer group
+ *  @retval bool false if a named column is missing from the header
+ */
+bool parseCsv(const char* data, std::size_t length,
+              const ReportColumns& columns,
+              std::map<std::string, uint32_t>* raw);
+
+/**
+ *  @brief Read and parse a CSV export
+ *  @param filename export file, possibly compressed
+ *  @param columns columns to read
+ *  @param raw receives the count of each computer group
+ *  @retval bool false if the file could not be read or lacks a named column
+ */
+bool loadCsv(const std::string& filename, const ReportColumns& columns,
+             std::map<std::string, uint32_t>* raw);
+
+}  // namespace bf
+
+#endif  // BIGFIX_CSV_H_
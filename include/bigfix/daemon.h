@@ -0,0 +1,75 @@
+/**
+ *  @file daemon.h
+ *  @brief Unix-domain socket daemon and client for repeated report runs
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BIGFIX_DAEMON_H_
+#define BIGFIX_DAEMON_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bf {
+
+/** seconds a client may take to send its request or accept its reply */
+const int kClientTimeout {30};
+
+/**
+ *  @brief Produces the report for one request
+ *  @param args command-line arguments of the request
+ *  @retval int exit status of the request
+ */
+typedef std::function<int(const std::vector<std::string>& args)> Request;
+
+/**
+ *  @brief Answer requests on a Unix-domain socket until killed
+ *  @details Requests are handled one at a time, in the client's working
+ *           directory, with the standard output redirected to the client so
+ *           that reports and error messages both reach it. Each request is a
+ *           32-bit length followed by the working directory and arguments,
+ *           each terminated by a NUL; the reply is the output followed by a
+ *           single byte holding the exit status. Only the daemon's own
+ *           user may connect, and a client that stalls is dropped after
+ *           kClientTimeout seconds.
+ *  @param path socket to listen on; a stale socket file is replaced
+ *  @param handler called for each request
+ *  @retval bool false if the socket could not be created
+ */
+bool serve(const std::string& path, Request handler);
+
+/**
+ *  @brief Have a daemon run a request and copy its output to stdout
+ *  @param path socket the daemon listens on
+ *  @param args command-line arguments of the request
+ *  @retval int exit status of the request, or 1 if the daemon could not be
+ *          reached
+ */
+int callDaemon(const std::string& path, const std::vector<std::string>& args);
+
+}  // namespace bf
+
+#endif  // BIGFIX_DAEMON_H_
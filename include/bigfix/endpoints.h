@@ -0,0 +1,266 @@
+/**
+ *  @file endpoints.h
+ *  @brief Per-endpoint report ingestion with exact distinct counts
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_ENDPOINTS_H_
+#define BIGFIX_ENDPOINTS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "bigfix/bitmap.h"
+#include "bigfix/hyperloglog.h"
+#include "bigfix/interner.h"
+#include "bigfix/spill.h"
+#include "bigfix/threadpool.h"
+
+namespace bf {
+
+/** separator between group names in the groups cell of an endpoint row */
+const char kGroupDelim {','};
+
+/**
+ *  @brief Membership of every endpoint in every computer group
+ *  @details Built from Web Reports exports with one row per endpoint
+ *           (computer ID, computer name, groups). In exact mode each group
+ *           keeps a bitmap of its computer IDs, so a computer listed in
+ *           several groups is counted once by unions, and any combination of
+ *           groups can be counted exactly. In approximate mode each group
+ *           keeps only a fixed-size HyperLogLog sketch instead, trading a
+ *           small, known error for memory that does not grow with the fleet.
+ *           Sets built from different files or threads can be merged.
+ */
+class EndpointSet {
+ private:
+  /**
+   *  @brief Whether groups are sketched rather than stored exactly
+   */
+  bool approximate_;
+
+  /**
+   *  @brief Distinct computer group names
+   */
+  Interner names_;
+
+  /**
+   *  @brief Computer IDs in each group, indexed by interned name
+   */
+  std::vector<Bitmap> groups_;
+
+  /**
+   *  @brief Computer IDs added since the last flush(), indexed by interned name
+   */
+  std::vector<std::vector<uint32_t>> pending_;
+
+  /**
+   *  @brief Approximate membership of each group, indexed by interned name
+   */
+  std::vector<HyperLogLog> sketches_;
+
+  /**
+   *  @brief Group and computer pairs added since the last flush(), used
+   *         instead of pending_ when memory is limited
+   */
+  ExternalSort spilled_;
+
+  /**
+   *  @brief Return the identifier of a group, adding it if it is new
+   *  @param name name of the computer group
+   *  @retval uint32_t interned name
+   */
+  uint32_t intern(const std::string& name);
+
+ public:
+  /**
+   *  @brief Construct an empty set
+   *  @param approximate keep HyperLogLog sketches instead of exact bitmaps
+   */
+  explicit EndpointSet(bool approximate = false);
+
+  /**
+   *  @brief Record that a computer belongs to a group
+   *  @details In exact mode this takes effect once flush() is called
+   *  @param computer computer ID
+   *  @param group name of the computer group
+   */
+  void add(uint32_t computer, const std::string& group);
+
+  /**
+   *  @brief Limit the memory held by computers waiting for flush()
+   *  @details Once the limit is reached, group and computer pairs are sorted
+   *           and spilled to temporary files, which flush() merges back
+   *  @param bytes memory for pending computers, or zero for no limit
+   */
+  void set_budget(std::size_t bytes);
+
+  /**
+   *  @brief Memory limit for computers waiting for flush()
+   *  @retval std::size_t bytes, or zero for no limit
+   */
+  std::size_t budget() const;
+
+  /**
+   *  @brief Move recently added computers into the group bitmaps
+   *  @details Computer IDs arrive in arbitrary order; sorting them first lets
+   *           each bitmap be built by appending instead of inserting
+   *  @retval bool false if spilled computers could not be read back
+   */
+  bool flush();
+
+  /**
+   *  @brief Fold another set into this one, group by name
+   *  @details The result is approximate if either set is
+   *  @param other set to merge in; must have been flushed
+   */
+  void merge(const EndpointSet& other);
+
+  /**
+   *  @brief Fold a single group's exact membership into this set
+   *  @details In approximate mode the computers are added to the sketch
+   *  @param name name of the computer group
+   *  @param members computer IDs in the group
+   */
+  void merge(const std::string& name, const Bitmap& members);
+
+  /**
+   *  @brief Fold a single group's sketch into this set
+   *  @details An exact set is switched to approximate mode first
+   *  @param name name of the computer group
+   *  @param sketch sketch of the computers in the group
+   *  @retval bool false if the sketch precision does not match
+   */
+  bool merge(const std::string& name, const HyperLogLog& sketch);
+
+  /**
+   *  @brief Switch to approximate mode, sketching the groups stored so far
+   *  @details Adding the same computers to a sketch or merging their sketches
+   *           gives identical registers, so exact and approximate sets can be
+   *           combined in any order with the same result
+   */
+  void sketch();
+
+  /**
+   *  @brief Number of distinct computer groups
+   *  @retval std::size_t number of groups
+   */
+  std::size_t size() const;
+
+  /**
+   *  @brief Name of a computer group
+   *  @param group identifier between 0 and size() - 1
+   *  @retval std::string name of the group
+   */
+  const std::string& name(uint32_t group) const;
+
+  /**
+   *  @brief Exact membership of a computer group; exact mode only
+   *  @param group identifier between 0 and size() - 1
+   *  @retval Bitmap computer IDs in the group
+   */
+  const Bitmap& members(uint32_t group) const;
+
+  /**
+   *  @brief Approximate membership of a computer group; approximate mode only
+   *  @param group identifier between 0 and size() - 1
+   *  @retval HyperLogLog sketch of the computers in the group
+   */
+  const HyperLogLog& sketch(uint32_t group) const;
+
+  /**
+   *  @brief Accessor method for the approximate_ property
+   *  @retval bool true if counts are HyperLogLog estimates
+   */
+  bool approximate() const;
+
+  /**
+   *  @brief Relative standard error of approximate counts
+   *  @retval double standard error as a fraction, 0 in exact mode
+   */
+  double error() const;
+
+  /**
+   *  @brief Number of distinct computers in at least one of several groups
+   *  @param names names of the computer groups; unknown names are ignored
+   *  @retval uint64_t size of the union of the groups
+   */
+  uint64_t distinct(const std::vector<std::string>& names) const;
+
+  /**
+   *  @brief Number of distinct computers in any group
+   *  @retval uint64_t size of the union of all groups
+   */
+  uint64_t distinct() const;
+
+  /**
+   *  @brief Per-group computer counts in the form produced by parseLine
+   *  @param raw receives the number of computers in each group
+   */
+  void counts(std::map<std::string, uint32_t>* raw) const;
+
+  /**
+   *  @brief Evaluate a set expression over group names
+   *  @details Names are combined left to right with '|' (union), '&'
+   *           (intersection) and '-' (difference), e.g. "OS-MBDA" counts the
+   *           computers in OS but not in MBDA. Names holding an operator
+   *           character are written in double quotes, e.g.
+   *           "Windows-Servers"&OS. In approximate mode only unions are
+   *           supported.
+   *  @param expression set expression
+   *  @param result receives the number of computers in the resulting set
+   *  @retval bool false if the expression names an unknown group, has an
+   *          unterminated quote or uses an operator the current mode does not
+   *          support
+   */
+  bool count(const std::string& expression, uint64_t* result) const;
+};
+
+/**
+ *  @brief Load a per-endpoint export
+ *  @param filename input file with one table row per endpoint, possibly
+ *         compressed
+ *  @param endpoints receives group membership of every endpoint
+ *  @retval bool false if the file could not be read
+ */
+bool loadEndpoints(const std::string& filename, EndpointSet* endpoints);
+
+/**
+ *  @brief Load several per-endpoint exports concurrently
+ *  @param filenames input files with one table row per endpoint
+ *  @param pool worker threads to load the files on
+ *  @param endpoints receives group membership of every endpoint, in the mode
+ *         it was constructed with
+ *  @retval bool false if any file could not be read
+ */
+bool loadEndpoints(const std::vector<std::string>& filenames, ThreadPool* pool,
+                   EndpointSet* endpoints);
+
+}  // namespace bf
+
+#endif  // BIGFIX_ENDPOINTS_H_
@@ -0,0 +1,400 @@
+/**
+ *  @file grouptable.h
+ *  @brief Column-oriented storage for computer group deployment counts
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_GROUPTABLE_H_
+#define BIGFIX_GROUPTABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bigfix/interner.h"
+#include "bigfix/view.h"
+
+class GroupTable;
+
+namespace bf {
+  /**
+   *  @brief Deployment bands used to color percentages
+   */
+  enum class Band : uint8_t {
+    kRed,    /**< below the amber threshold */
+    kAmber,  /**< at or above amber but below the green threshold */
+    kGreen   /**< at or above the green threshold */
+  };
+
+  /** largest deployment percentage that can be represented */
+  const uint16_t kMaxPercent {65535};
+
+  /** row index returned by GroupTable::find() for unknown groups */
+  const std::size_t kNoRow {SIZE_MAX};
+
+  /** default lowest percentage in the amber band */
+  const uint16_t kAmberPercent {80};
+
+  /** default lowest percentage in the green band */
+  const uint16_t kGreenPercent {95};
+}  // namespace bf
+
+/**
+ *  @brief Model class for BigFix deployment information for a single computer
+ *         group, following the model-view-controller software design pattern
+ *  @details ComputerGroup contains all the operations and attributes associated
+ *           with the deployment information for a single computer groups. It
+ *           is a lightweight view over one row of a GroupTable and is cheap to
+ *           copy; it remains valid until the table is destroyed.
+ */
+class ComputerGroup {
+ private:
+  /**
+   *  @brief Table holding this computer group
+   */
+  GroupTable* table_ {nullptr};
+
+  /**
+   *  @brief Row of this computer group within table_
+   */
+  std::size_t row_ {0};
+
+ public:
+  /**
+   *  @brief Construct a view over one row of a group table
+   *  @param table table holding the computer group
+   *  @param row row of the computer group within the table
+   */
+  ComputerGroup(GroupTable* table, std::size_t row);
+
+  /**
+   *  @brief Accessor method for the name_ property
+   *  @retval std::string Name of this computer group
+   */
+  const std::string& name() const;
+
+  /**
+   *  @brief Return the length of widest display element for this record
+   *  @details Only the elements of the given rows are formatted
+   *  @param rows rows being displayed, a combination of bf::Row values
+   *  @retval uint8_t widest of the name and the displayed elements
+   */
+  uint8_t widest(unsigned rows = bf::kAllRows) const;
+
+  /**
+   *  @brief Return formatted version of the computer group name
+   *  @param width column width, as returned by widest()
+   *  @retval output display formatted version of the computer group name
+   */
+  std::string formatted_name(uint8_t width) const;
+
+  /**
+   *  @brief Accessor method for the current_ property
+   *  @retval Number of computers currently in this computer group
+   */
+  uint32_t current() const;
+
+  /**
+   *  @brief Return formatted version of the current_ property
+   *  @param width column width, as returned by widest()
+   *  @retval output display formatted version of the number of computers 
+   *          currently in this computer group
+   */
+  std::string formatted_current(uint8_t width) const;
+
+  /**
+   *  @brief Accessor method for the target_ property
+   *  @retval Number of computers expected to be in this computer group
+   */
+  uint32_t target() const;
+
+  /**
+   *  @brief Return formatted version of the target_ property
+   *  @param width column width, as returned by widest()
+   *  @retval output display formatted version of the number of computers
+   *          expected to be in this computer group
+   */
+  std::string formatted_target(uint8_t width) const;
+
+  /**
+   *  @brief Accessor method for the deployment percentage computed value
+   *  @retval uint16_t Percentage of computers deployed in this computer group
+   */
+  uint16_t percent() const;
+
+  /**
+   *  @brief Accessor method for the deployment band computed value
+   *  @retval bf::Band band the deployment percentage falls in
+   */
+  bf::Band band() const;
+
+  /**
+   *  @brief Return formatted version of the deployment percentage computed
+   *         value
+   *  @param width column width, as returned by widest()
+   *  @retval output display formatted version of the Percentage of computers 
+   *          deployed in this computer group
+   */
+  std::string formatted_percent(uint8_t width) const;
+
+  /**
+   *  @brief Return the percentage as displayed, before padding
+   *  @retval std::string bold, and colored if banded, deployment percentage
+   */
+  std::string percent_text() const;
+
+  /**
+   *  @brief Mutator method for the current_ property
+   *  @param current Number of computers currently in this computer group
+   */
+  void set_current(uint32_t current);
+
+  /**
+   *  @brief Mutator method for the target_ property
+   *  @param target Number of computers expected to be in this computer group
+   */
+  void set_target(uint32_t target);
+};
+
+/**
+ *  @brief Deployment counts for many computer groups, one array per column
+ *  @details Names are interned and each column is stored contiguously, so
+ *           totals and percentages are simple loops over plain integer arrays
+ *           that the compiler can vectorize. Deployment percentages and their
+ *           bands are cached and recomputed for all rows at once, with SIMD
+ *           where available, the first time they are needed after any change.
+ */
+class GroupTable {
+ private:
+  /**
+   *  @brief Distinct computer group names, shared by copies of the table
+   *         until one of them adds a new name
+   */
+  std::shared_ptr<bf::Interner> names_ {std::make_shared<bf::Interner>()};
+
+  /**
+   *  @brief Interned name of each row
+   */
+  std::vector<uint32_t> name_id_;
+
+  /**
+   *  @brief First row holding each interned name, indexed by identifier, or
+   *         bf::kNoRow for a name without a row
+   */
+  std::vector<std::size_t> row_of_;
+
+  /**
+   *  @brief Number of computers currently in each computer group
+   */
+  std::vector<uint32_t> current_;
+
+  /**
+   *  @brief Number of computers expected to be in each computer group
+   */
+  std::vector<uint32_t> target_;
+
+  /**
+   *  @brief Cached deployment percentage of each computer group
+   */
+  std::vector<uint16_t> percent_;
+
+  /**
+   *  @brief Cached deployment band of each computer group
+   */
+  std::vector<uint8_t> band_;
+
+  /**
+   *  @brief Lowest percentage in the amber band
+   */
+  uint16_t amber_ {bf::kAmberPercent};
+
+  /**
+   *  @brief Lowest percentage in the green band
+   */
+  uint16_t green_ {bf::kGreenPercent};
+
+  /**
+   *  @brief Whether output should be colored by deployment band
+   */
+  bool banded_ {false};
+
+  /**
+   *  @brief Set when a count changed after percent_ was last computed
+   */
+  bool stale_ {false};
+
+  /**
+   *  @brief Identifier of a name, interning it if it is new
+   *  @details The names are copied first if another table shares them
+   *  @param name name of a computer group
+   *  @retval uint32_t identifier of the name
+   */
+  uint32_t intern(const std::string& name);
+
+  /**
+   *  @brief Compute the cached percentage and band of a single row
+   *  @param row row to update
+   */
+  void compute_row(std::size_t row);
+
+  friend class ComputerGroup;
+
+ public:
+  /**
+   *  @brief Iterator yielding a ComputerGroup view for each row
+   */
+  class iterator {
+   private:
+    GroupTable* table_;
+    std::size_t row_;
+
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef ComputerGroup value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef ComputerGroup* pointer;
+    typedef ComputerGroup reference;
+
+    iterator(GroupTable* table, std::size_t row) : table_(table), row_(row) {}
+    ComputerGroup operator*() const { return ComputerGroup(table_, row_); }
+    iterator& operator++() { ++row_; return *this; }
+    bool operator==(const iterator& o) const { return row_ == o.row_; }
+    bool operator!=(const iterator& o) const { return row_ != o.row_; }
+  };
+
+  /**
+   *  @brief Append a computer group with zero counts
+   *  @param name name of the computer group
+   *  @retval ComputerGroup view over the new row
+   */
+  ComputerGroup add(const std::string& name);
+
+  /**
+   *  @brief Intern a name without adding a row
+   *  @details Copies of the table can then add that name without copying
+   *           the names they share with this table
+   *  @param name name of a computer group that copies will add
+   */
+  void reserve(const std::string& name);
+
+  /**
+   *  @brief Row holding a computer group
+   *  @param name name of the computer group
+   *  @retval std::size_t first row with that name, or kNoRow if none
+   */
+  std::size_t find(const std::string& name) const;
+
+  /**
+   *  @brief Return a view over one row
+   *  @param row row index, less than size()
+   *  @retval ComputerGroup view over the row
+   */
+  ComputerGroup operator[](std::size_t row);
+
+  /**
+   *  @brief Number of rows
+   *  @retval std::size_t number of computer groups in this table
+   */
+  std::size_t size() const;
+
+  /**
+   *  @brief Sum of the current column
+   *  @retval uint32_t number of computers currently in all computer groups
+   */
+  uint32_t total_current() const;
+
+  /**
+   *  @brief Sum of the target column
+   *  @retval uint32_t number of computers expected in all computer groups
+   */
+  uint32_t total_target() const;
+
+  /**
+   *  @brief Recompute the cached percentage and band of every row in one pass
+   */
+  void compute_percent();
+
+  /**
+   *  @brief Enable colored output and set the deployment band thresholds
+   *  @param amber lowest percentage in the amber band
+   *  @param green lowest percentage in the green band
+   */
+  void set_bands(uint16_t amber, uint16_t green);
+
+  /**
+   *  @brief Whether output should be colored by deployment band
+   *  @retval bool true once set_bands() has been called
+   */
+  bool banded() const;
+
+  /**
+   *  @brief Accessor method for the interned names
+   *  @retval bf::Interner distinct computer group names
+   */
+  const bf::Interner& names() const;
+
+  /**
+   *  @brief Accessor method for the name identifier column
+   *  @retval std::vector<uint32_t> interned name of each row
+   */
+  const std::vector<uint32_t>& name_ids() const;
+
+  /**
+   *  @brief Accessor method for the current column
+   *  @retval std::vector<uint32_t> number of computers in each computer group
+   */
+  const std::vector<uint32_t>& currents() const;
+
+  /**
+   *  @brief Accessor method for the target column
+   *  @retval std::vector<uint32_t> number of computers expected in each
+   *          computer group
+   */
+  const std::vector<uint32_t>& targets() const;
+
+  /**
+   *  @brief Accessor method for the percentage column, recomputed if stale
+   *  @retval std::vector<uint16_t> deployment percentage of each computer
+   *          group
+   */
+  const std::vector<uint16_t>& percents();
+
+  /**
+   *  @brief Iterator over the first row
+   *  @retval iterator iterator yielding a view over each row in turn
+   */
+  iterator begin();
+
+  /**
+   *  @brief Iterator past the last row
+   *  @retval iterator end of iteration
+   */
+  iterator end();
+};
+
+#endif  // BIGFIX_GROUPTABLE_H_
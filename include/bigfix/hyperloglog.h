@@ -0,0 +1,115 @@
+/**
+ *  @file hyperloglog.h
+ *  @brief Mergeable approximate distinct counter for computer identifiers
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_HYPERLOGLOG_H_
+#define BIGFIX_HYPERLOGLOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bf {
+
+/** default number of index bits, giving 4 KiB sketches and 1.6% error */
+const uint8_t kSketchPrecision {12};
+
+/**
+ *  @brief HyperLogLog sketch estimating the number of distinct computers
+ *  @details Uses 2^precision one-byte registers regardless of how many
+ *           computers are added. Sketches of the same precision built from
+ *           different files, threads or days can be merged, and the result is
+ *           the same as if every computer had been added to a single sketch.
+ */
+class HyperLogLog {
+ private:
+  /**
+   *  @brief Number of leading hash bits used to select a register
+   */
+  uint8_t precision_;
+
+  /**
+   *  @brief Largest leading-zero rank observed for each register
+   */
+  std::vector<uint8_t> registers_;
+
+ public:
+  /**
+   *  @brief Construct an empty sketch
+   *  @param precision number of index bits, between 4 and 18
+   */
+  explicit HyperLogLog(uint8_t precision = kSketchPrecision);
+
+  /**
+   *  @brief Add a computer to the sketch
+   *  @param computer computer ID
+   */
+  void add(uint32_t computer);
+
+  /**
+   *  @brief Fold another sketch into this one
+   *  @param other sketch of the same precision
+   *  @retval bool false if the precisions differ and nothing was merged
+   */
+  bool merge(const HyperLogLog& other);
+
+  /**
+   *  @brief Estimated number of distinct computers added
+   *  @retval uint64_t estimate, using linear counting for small sets
+   */
+  uint64_t estimate() const;
+
+  /**
+   *  @brief Relative standard error of estimate()
+   *  @retval double standard error as a fraction of the estimate
+   */
+  double error() const;
+
+  /**
+   *  @brief Accessor method for the precision_ property
+   *  @retval uint8_t number of index bits
+   */
+  uint8_t precision() const;
+
+  /**
+   *  @brief Accessor method for the registers_ property
+   *  @retval std::vector<uint8_t> register values
+   */
+  const std::vector<uint8_t>& registers() const;
+
+  /**
+   *  @brief Replace the register values, e.g. when loading a saved sketch
+   *  @param registers 2^precision register values
+   *  @retval bool false if the number of registers does not match
+   */
+  bool set_registers(const std::vector<uint8_t>& registers);
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_HYPERLOGLOG_H_
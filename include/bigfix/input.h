@@ -0,0 +1,180 @@
+/**
+ *  @file input.h
+ *  @brief Line-oriented report input with transparent decompression
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_INPUT_H_
+#define BIGFIX_INPUT_H_
+
+#include <cstddef>
+#include <fstream>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include "bigfix/arena.h"
+#include "bigfix/ringbuffer.h"
+
+namespace bf {
+
+/**
+ *  @brief Compression formats recognized by their leading magic bytes
+ */
+enum class Compression {
+  kNone,  /**< plain text */
+  kGzip,  /**< gzip, RFC 1952 */
+  kZstd   /**< Zstandard, RFC 8878 */
+};
+
+/** size of each decompressed chunk handed to the tokenizer */
+const std::size_t kChunkSize {64 * 1024};
+
+/** number of decompressed chunks that may be in flight between threads */
+const std::size_t kRingDepth {8};
+
+/**
+ *  @brief Identify the compression format from the first bytes of a file
+ *  @param magic leading bytes of the file, possibly fewer than four
+ *  @param length number of bytes available in magic
+ *  @retval Compression detected format, kNone if unrecognized
+ */
+Compression detect(const unsigned char* magic, std::size_t length);
+
+/**
+ *  @brief Reads a report file line by line, decompressing it if needed
+ *  @details Plain files are read directly. Compressed files are inflated on a
+ *           background thread into fixed-size chunks which are passed through
+ *           a bounded ring buffer, so decompression of the next chunk overlaps
+ *           with tokenizing the current one.
+ */
+class Input {
+ private:
+  /**
+   *  @brief Underlying file, opened in binary mode
+   */
+  std::ifstream fs_;
+
+  /**
+   *  @brief Compression format detected when the file was opened
+   */
+  Compression compression_ {Compression::kNone};
+
+  /**
+   *  @brief Decompressed chunks waiting to be tokenized
+   */
+  RingBuffer<std::string> ring_;
+
+  /**
+   *  @brief Background decompression thread, if any
+   */
+  std::thread worker_;
+
+  /**
+   *  @brief Chunk currently being split into lines
+   */
+  std::string chunk_;
+
+  /**
+   *  @brief Read position within chunk_
+   */
+  std::size_t pos_ {0};
+
+  /**
+   *  @brief Set by the decompression thread if the stream was corrupt
+   */
+  bool failed_ {false};
+
+  /**
+   *  @brief Decompression thread body for gzip input
+   */
+  void inflateGzip();
+
+  /**
+   *  @brief Decompression thread body for zstd input
+   */
+  void inflateZstd();
+
+ public:
+  /**
+   *  @brief Open a report file and start decompressing it if necessary
+   *  @param filename file to read
+   *  @param depth number of decompressed chunks buffered ahead of the reader
+   */
+  explicit Input(const std::string& filename, std::size_t depth = kRingDepth);
+
+  /**
+   *  @brief Stop the decompression thread and close the file
+   */
+  ~Input();
+
+  Input(const Input&) = delete;
+  Input& operator=(const Input&) = delete;
+
+  /**
+   *  @brief Whether the file was opened successfully
+   *  @retval bool true if lines can be read
+   */
+  bool is_open() const;
+
+  /**
+   *  @brief Accessor method for the compression_ property
+   *  @retval Compression compression format of the file
+   */
+  Compression compression() const;
+
+  /**
+   *  @brief Whether decompression stopped early because of corrupt input
+   *  @retval bool true if the input was truncated or invalid
+   */
+  bool failed() const;
+
+  /**
+   *  @brief Read the next line, without its terminating newline
+   *  @param line receives the line
+   *  @retval bool false once no more lines are available
+   */
+  bool getline(std::string* line);
+};
+
+/**
+ *  @brief Decompress an entire gzip or zstd buffer held in memory
+ *  @details Instantiated for std::string and ArenaString
+ *  @param in compressed data
+ *  @param out receives the decompressed data
+ *  @retval bool false if the data is corrupt, truncated or unsupported
+ */
+template <typename String>
+bool decompress(const std::string& in, String* out);
+
+/**
+ *  @brief Remove a trailing compression suffix such as ".gz" from a filename
+ *  @param filename name of a possibly compressed file
+ *  @retval std::string filename without its compression suffix
+ */
+std::string uncompressedName(const std::string& filename);
+
+}  // namespace bf
+
+#endif  // BIGFIX_INPUT_H_
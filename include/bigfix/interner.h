@@ -0,0 +1,91 @@
+/**
+ *  @file interner.h
+ *  @brief Maps computer group names to small dense integer identifiers
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_INTERNER_H_
+#define BIGFIX_INTERNER_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bf {
+
+/**
+ *  @brief Stores each distinct computer group name once
+ *  @details Identifiers are assigned in first-seen order starting at zero, so
+ *           they can index directly into per-group arrays.
+ */
+class Interner {
+ private:
+  /**
+   *  @brief Names indexed by identifier
+   */
+  std::vector<std::string> names_;
+
+  /**
+   *  @brief Identifiers indexed by name
+   */
+  std::unordered_map<std::string, uint32_t> ids_;
+
+ public:
+  /** identifier returned by find() for unknown names */
+  static const uint32_t kMissing {UINT32_MAX};
+
+  /**
+   *  @brief Return the identifier for a name, assigning one if it is new
+   *  @param name computer group name
+   *  @retval uint32_t identifier of the name
+   */
+  uint32_t intern(const std::string& name);
+
+  /**
+   *  @brief Return the identifier for a name without assigning one
+   *  @param name computer group name
+   *  @retval uint32_t identifier of the name, or kMissing if unknown
+   */
+  uint32_t find(const std::string& name) const;
+
+  /**
+   *  @brief Return the name for an identifier
+   *  @param id identifier previously returned by intern()
+   *  @retval std::string computer group name
+   */
+  const std::string& name(uint32_t id) const;
+
+  /**
+   *  @brief Number of distinct names
+   *  @retval std::size_t number of names interned so far
+   */
+  std::size_t size() const;
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_INTERNER_H_
@@ -0,0 +1,84 @@
+/**
+ *  @file join.h
+ *  @brief Join of report counts against the target table
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_JOIN_H_
+#define BIGFIX_JOIN_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bigfix/grouptable.h"
+
+namespace bf {
+
+/**
+ *  @brief A target row together with the count reported for its group
+ */
+struct Match {
+  /** row of the target table */
+  std::size_t row;
+  /** number of computers reported for the group */
+  uint32_t count;
+};
+
+/**
+ *  @brief Outcome of joining report counts with the target table
+ */
+struct JoinResult {
+  /** target rows that have a report count, in row order */
+  std::vector<Match> matched;
+  /** target rows that the report does not mention, in row order */
+  std::vector<std::size_t> target_only;
+  /** report groups that have no target, with their counts, by name */
+  std::vector<std::pair<std::string, uint32_t>> report_only;
+  /** number of computers in matched groups */
+  uint64_t matched_computers {0};
+  /** number of computers in report-only groups */
+  uint64_t report_only_computers {0};
+};
+
+/**
+ *  @brief Hash join report counts with the target table by group name
+ *  @details Each report group is resolved to an interned identifier with
+ *           one probe of the table's interner, and rows are matched on those
+ *           identifiers, so the join is linear in the number of groups on
+ *           both sides. Neither input is modified.
+ *  @param raw computer counts by group name, as read from a report
+ *  @param final target table
+ *  @param result receives the matched, target-only and report-only groups
+ */
+void join(const std::map<std::string, uint32_t>& raw, const GroupTable& final,
+          JoinResult* result);
+
+}  // namespace bf
+
+#endif  // BIGFIX_JOIN_H_
@@ -0,0 +1,97 @@
+/**
+ *  @file mappedfile.h
+ *  @brief Read-only memory mapping of an entire file
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_MAPPEDFILE_H_
+#define BIGFIX_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace bf {
+
+/**
+ *  @brief Maps a whole file into memory for a single read-only pass
+ *  @details The kernel pages the file in on demand, so large inputs are
+ *           scanned without first being copied into a buffer. The mapping is
+ *           released when the object is destroyed.
+ */
+class MappedFile {
+ private:
+  /**
+   *  @brief First byte of the mapping, or nullptr for an empty file
+   */
+  const char* data_ {nullptr};
+
+  /**
+   *  @brief Length of the file in bytes
+   */
+  std::size_t size_ {0};
+
+  /**
+   *  @brief Whether the file was opened successfully
+   */
+  bool open_ {false};
+
+ public:
+  /**
+   *  @brief Map a file into memory
+   *  @param filename file to map
+   */
+  explicit MappedFile(const std::string& filename);
+
+  /**
+   *  @brief Unmap the file
+   */
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   *  @brief Whether the file was opened successfully
+   *  @retval bool true if data() may be read
+   */
+  bool is_open() const;
+
+  /**
+   *  @brief Accessor method for the data_ property
+   *  @retval const char* contents of the file, not null-terminated
+   */
+  const char* data() const;
+
+  /**
+   *  @brief Accessor method for the size_ property
+   *  @retval std::size_t length of the file in bytes
+   */
+  std::size_t size() const;
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_MAPPEDFILE_H_
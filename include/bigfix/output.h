@@ -0,0 +1,186 @@
+/**
+ *  @file output.h
+ *  @brief Buffered report output to stdout or to an atomically replaced file
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BIGFIX_OUTPUT_H_
+#define BIGFIX_OUTPUT_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace bf {
+
+/** size of each output buffer block */
+const std::size_t kOutputBlock {64 * 1024};
+
+/** number of full blocks gathered into a single writev() call */
+const std::size_t kOutputBlocks {16};
+
+/**
+ *  @brief Collects report output in large reusable blocks
+ *  @details Text is appended to fixed-size blocks which are written together
+ *           with writev() once enough have filled up, on flush() and on
+ *           commit(). Output to a file goes to a temporary file in the same
+ *           directory which commit() renames over the destination, so a reader
+ *           polling the file only ever sees complete output. If commit() is
+ *           never called the temporary file is removed.
+ */
+class Output {
+ private:
+  /**
+   *  @brief Destination file, or empty for stdout
+   */
+  std::string filename_;
+
+  /**
+   *  @brief Temporary file receiving the output until commit()
+   */
+  std::string temporary_;
+
+  /**
+   *  @brief Descriptor written to, or -1 if the file could not be created
+   */
+  int fd_ {-1};
+
+  /**
+   *  @brief Buffer blocks; capacity is kept when they are written out
+   */
+  std::vector<std::string> blocks_;
+
+  /**
+   *  @brief Number of blocks holding unwritten output
+   */
+  std::size_t used_ {0};
+
+  /**
+   *  @brief Set once a write has failed
+   */
+  bool failed_ {false};
+
+  /**
+   *  @brief Set once the output has been committed
+   */
+  bool committed_ {false};
+
+ public:
+  /**
+   *  @brief Construct an output to stdout or to a file
+   *  @param filename file to replace on commit(), or empty for stdout
+   */
+  explicit Output(const std::string& filename = std::string());
+
+  /**
+   *  @brief Write out any buffered output to stdout, or discard an
+   *         uncommitted file
+   */
+  ~Output();
+
+  Output(const Output&) = delete;
+  Output& operator=(const Output&) = delete;
+
+  /**
+   *  @brief Whether output can be written
+   *  @retval bool false if the temporary file could not be created
+   */
+  bool is_open() const;
+
+  /**
+   *  @brief Append text
+   *  @param data start of the text
+   *  @param length length of the text
+   */
+  void write(const char* data, std::size_t length);
+
+  /**
+   *  @brief Append text
+   *  @param text text to append
+   */
+  void write(const std::string& text);
+
+  /**
+   *  @brief Append printf-style formatted text
+   *  @param format printf format string
+   */
+  void print(const char* format, ...)
+      __attribute__((format(printf, 2, 3)));
+
+  /**
+   *  @brief Write out all buffered output
+   *  @details Anything already printed to stdout with printf() is written
+   *           first, so both kinds of output stay in order
+   *  @retval bool false if a write has failed
+   */
+  bool flush();
+
+  /**
+   *  @brief Write out all buffered output and move a file into place
+   *  @retval bool false if the output could not be written or renamed
+   */
+  bool commit();
+};
+
+/**
+ *  @brief Print an error or warning to stdout, like printf()
+ *  @details If the calling thread is deferring messages the text is held
+ *           instead; see DeferMessages
+ *  @param format printf format string
+ */
+void message(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ *  @brief Holds the messages of the current thread while it is in scope
+ *  @details Inputs loaded in parallel finish in no particular order, so each
+ *           task defers the messages for its input and the caller prints them
+ *           in input order once all tasks are done. Scopes may be nested.
+ */
+class DeferMessages {
+ private:
+  /**
+   *  @brief Messages held by the enclosing scope, or nullptr if none
+   */
+  std::string* previous_;
+
+ public:
+  /**
+   *  @brief Start holding messages
+   *  @param messages receives the text of every message until destruction
+   */
+  explicit DeferMessages(std::string* messages);
+
+  /**
+   *  @brief Stop holding messages
+   */
+  ~DeferMessages();
+
+  DeferMessages(const DeferMessages&) = delete;
+  DeferMessages& operator=(const DeferMessages&) = delete;
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_OUTPUT_H_
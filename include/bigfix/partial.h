@@ -0,0 +1,133 @@
+/**
+ *  @file partial.h
+ *  @brief Serialized partial aggregates for sharded ingestion
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_PARTIAL_H_
+#define BIGFIX_PARTIAL_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include "bigfix/endpoints.h"
+
+namespace bf {
+
+/** leading bytes of a partial aggregate file */
+const char kPartialMagic[] {"BFPA"};
+
+/** version of the partial aggregate format written by save() */
+const uint8_t kPartialVersion {1};
+
+/**
+ *  @brief Counts gathered from a subset of the inputs, to be merged later
+ *  @details A partial holds the per-group computer counts read from status
+ *           reports together with the group memberships or sketches read from
+ *           per-endpoint exports, keyed by group name. Partials written by
+ *           separate processes can be folded together in any grouping and any
+ *           order: counts are summed, memberships are unioned and sketches
+ *           are merged register by register, so a tree of merges gives the
+ *           same result as merging every shard at once. load() folds a file
+ *           in one group at a time and never holds more than one group of the
+ *           incoming partial in memory.
+ */
+class Partial {
+ private:
+  /**
+   *  @brief Newest report date of the inputs, in kDate format
+   */
+  std::string date_;
+
+  /**
+   *  @brief Summed computer counts from status reports, by group name
+   */
+  std::map<std::string, uint32_t> raw_;
+
+  /**
+   *  @brief Group membership from per-endpoint exports
+   */
+  EndpointSet endpoints_;
+
+ public:
+  /**
+   *  @brief Construct an empty partial
+   *  @param approximate sketch endpoint groups instead of storing them exactly
+   */
+  explicit Partial(bool approximate = false);
+
+  /**
+   *  @brief Add the counts read from a status report
+   *  @param date report date; the newest date seen is kept
+   *  @param raw computer counts by group name
+   */
+  void add(const std::string& date,
+           const std::map<std::string, uint32_t>& raw);
+
+  /**
+   *  @brief Add the group memberships read from per-endpoint exports
+   *  @param date export date; the newest date seen is kept
+   *  @param endpoints flushed set of group memberships
+   */
+  void add(const std::string& date, const EndpointSet& endpoints);
+
+  /**
+   *  @brief Fold a partial aggregate file into this one
+   *  @param filename file written by save()
+   *  @retval bool false if the file is unreadable, truncated or corrupt; the
+   *          groups read before the error remain merged
+   */
+  bool load(const std::string& filename);
+
+  /**
+   *  @brief Write this partial aggregate to a file
+   *  @param filename file to create or replace
+   *  @retval bool false if the file could not be written
+   */
+  bool save(const std::string& filename) const;
+
+  /**
+   *  @brief Accessor method for the date_ property
+   *  @retval std::string report date, empty if unknown
+   */
+  const std::string& date() const;
+
+  /**
+   *  @brief Accessor method for the raw_ property
+   *  @retval std::map<std::string, uint32_t> summed counts by group name
+   */
+  const std::map<std::string, uint32_t>& raw() const;
+
+  /**
+   *  @brief Accessor method for the endpoints_ property
+   *  @retval EndpointSet merged group memberships
+   */
+  const EndpointSet& endpoints() const;
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_PARTIAL_H_
@@ -0,0 +1,114 @@
+/**
+ *  @file readengine.h
+ *  @brief Asynchronous whole-file reader for batch report ingestion
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_READENGINE_H_
+#define BIGFIX_READENGINE_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bf {
+
+/** default number of file reads kept in flight */
+const std::size_t kReadDepth {16};
+
+/**
+ *  @brief Reads many files concurrently and hands over each complete buffer
+ *  @details Keeps up to depth reads outstanding, using io_uring when built
+ *           with liburing and a pool of pread() worker threads otherwise.
+ *           Completed buffers are always delivered on the calling thread, in
+ *           completion order, so handlers need no locking of their own.
+ */
+class ReadEngine {
+ public:
+  /**
+   *  @brief Callback receiving a completed read
+   *  @param index position of the file in the list passed to run()
+   *  @param buffer entire file contents, which the handler may move from
+   *  @param ok false if the file could not be opened or read
+   */
+  typedef std::function<void(std::size_t index, std::string* buffer,
+                             bool ok)> Handler;
+
+ private:
+  /**
+   *  @brief Maximum number of reads in flight
+   */
+  std::size_t depth_;
+
+  /**
+   *  @brief Read files using a pool of blocking pread() threads
+   *  @param files files to read
+   *  @param handler callback for each completed read
+   */
+  void runThreads(const std::vector<std::string>& files, Handler handler);
+
+#ifdef BIGFIX_HAVE_LIBURING
+  /**
+   *  @brief Read files using a single io_uring submission queue
+   *  @param files files to read
+   *  @param handler callback for each completed read
+   *  @retval bool false if io_uring is unavailable on this kernel
+   */
+  bool runUring(const std::vector<std::string>& files, Handler handler);
+#endif
+
+ public:
+  /**
+   *  @brief Construct a read engine
+   *  @param depth maximum number of reads in flight, at least one
+   */
+  explicit ReadEngine(std::size_t depth = kReadDepth);
+
+  /**
+   *  @brief Read every file and pass each buffer to handler as it completes
+   *  @param files files to read
+   *  @param handler callback invoked exactly once per file
+   */
+  void run(const std::vector<std::string>& files, Handler handler);
+
+  /**
+   *  @brief Name of the backend run() will use
+   *  @retval const char* "io_uring" or "pread"
+   */
+  const char* backend() const;
+};
+
+/**
+ *  @brief List the deployment status files in a directory
+ *  @param directory directory to scan
+ *  @retval std::vector<std::string> report paths sorted by name
+ */
+std::vector<std::string> listReports(const std::string& directory);
+
+}  // namespace bf
+
+#endif  // BIGFIX_READENGINE_H_
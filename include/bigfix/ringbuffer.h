@@ -0,0 +1,148 @@
+/**
+ *  @file ringbuffer.h
+ *  @brief Bounded blocking ring buffer connecting pipeline stages
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_RINGBUFFER_H_
+#define BIGFIX_RINGBUFFER_H_
+
+#include <condition_variable>  // NOLINT
+#include <cstddef>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace bf {
+
+/**
+ *  @brief Fixed-capacity blocking queue
+ *  @details Safe for any number of producer and consumer threads. push()
+ *           blocks while the buffer is full and pop() blocks while it is
+ *           empty, so a fast stage can never run more than capacity items
+ *           ahead of a slow one. Either side may close() the buffer: pending
+ *           items are still drained by pop(), while push() starts failing so
+ *           producers can stop early.
+ */
+template <typename T>
+class RingBuffer {
+ private:
+  /**
+   *  @brief Storage for queued items
+   */
+  std::vector<T> slots_;
+
+  /**
+   *  @brief Index of the oldest queued item
+   */
+  std::size_t head_ {0};
+
+  /**
+   *  @brief Number of queued items
+   */
+  std::size_t count_ {0};
+
+  /**
+   *  @brief Set once no further items will be accepted
+   */
+  bool closed_ {false};
+
+  /**
+   *  @brief Guards all of the above
+   */
+  std::mutex mutex_;
+
+  /**
+   *  @brief Signalled when an item is queued or the buffer is closed
+   */
+  std::condition_variable not_empty_;
+
+  /**
+   *  @brief Signalled when an item is dequeued or the buffer is closed
+   */
+  std::condition_variable not_full_;
+
+ public:
+  /**
+   *  @brief Construct a ring buffer holding at most capacity items
+   *  @param capacity maximum number of queued items, at least one
+   */
+  explicit RingBuffer(std::size_t capacity)
+      : slots_(capacity > 0 ? capacity : 1) {
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  /**
+   *  @brief Queue an item, waiting for a free slot if necessary
+   *  @param item item to queue
+   *  @retval bool false if the buffer was closed and the item discarded
+   */
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return closed_ || count_ < slots_.size(); });
+    if (closed_) {
+      return false;
+    }
+    slots_[(head_ + count_) % slots_.size()] = std::move(item);
+    ++count_;
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /**
+   *  @brief Dequeue the oldest item, waiting for one if necessary
+   *  @param item receives the dequeued item
+   *  @retval bool false once the buffer is closed and fully drained
+   */
+  bool pop(T* item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || count_ > 0; });
+    if (count_ == 0) {
+      return false;
+    }
+    *item = std::move(slots_[head_]);
+    head_ = (head_ + 1) % slots_.size();
+    --count_;
+    not_full_.notify_one();
+    return true;
+  }
+
+  /**
+   *  @brief Stop accepting items and wake up all waiting threads
+   */
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_RINGBUFFER_H_
@@ -0,0 +1,153 @@
+/**
+ *  @file spill.h
+ *  @brief External sort of 64-bit keys within a memory budget
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef BIGFIX_SPILL_H_
+#define BIGFIX_SPILL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bf {
+
+/** largest number of keys read from each run at a time while merging */
+const std::size_t kMergeBlock {8192};
+
+/** number of runs of the same size merged into one larger run */
+const std::size_t kMergeFanIn {16};
+
+/**
+ *  @brief Sorts keys that may not fit in memory
+ *  @details Keys are collected in memory until they would exceed the budget,
+ *           then sorted and written to an anonymous temporary file as a run.
+ *           merge() combines the runs and the keys still in memory with a
+ *           k-way merge, visiting every key in ascending order. Runs of the
+ *           same size are merged kMergeFanIn at a time as they appear, so
+ *           only a few are ever open at once. Runs are created in $TMPDIR,
+ *           or /tmp, and unlinked as soon as they are opened, so they
+ *           disappear even if the program is killed.
+ */
+class ExternalSort {
+ private:
+  /**
+   *  @brief Bytes of keys kept in memory before spilling, or zero for no limit
+   */
+  std::size_t budget_ {0};
+
+  /**
+   *  @brief Keys added since the last run was written
+   */
+  std::vector<uint64_t> keys_;
+
+  /**
+   *  @brief Sorted runs written so far
+   */
+  std::vector<std::shared_ptr<FILE>> runs_;
+
+  /**
+   *  @brief How many times the keys in each run have been merged
+   */
+  std::vector<unsigned> levels_;
+
+  /**
+   *  @brief Set once a run could not be written
+   */
+  bool failed_ {false};
+
+  /**
+   *  @brief Sort the keys in memory and write them out as a run
+   */
+  void spill();
+
+  /**
+   *  @brief Merge the last kMergeFanIn runs while they share a level
+   *  @details Keeps the number of open runs logarithmic in the number of
+   *           keys, however small the budget
+   */
+  void compact();
+
+  /**
+   *  @brief Number of keys read from each run at a time, within the budget
+   *  @retval std::size_t keys per read
+   */
+  std::size_t block() const;
+
+ public:
+  /**
+   *  @brief Construct an empty sort
+   *  @param budget bytes of keys kept in memory, or zero for no limit
+   */
+  explicit ExternalSort(std::size_t budget = 0);
+
+  /**
+   *  @brief Add a key, spilling a run if the budget is reached
+   *  @param key key to sort
+   */
+  void add(uint64_t key) {
+    keys_.push_back(key);
+    if (budget_ > 0 && keys_.size() * sizeof(uint64_t) >= budget_) {
+      spill();
+    }
+  }
+
+  /**
+   *  @brief Visit every key added so far in ascending order, then start over
+   *  @param visit called once per key, duplicates included
+   *  @retval bool false if a run could not be written or read back
+   */
+  bool merge(const std::function<void(uint64_t)>& visit);
+
+  /**
+   *  @brief Accessor method for the budget_ property
+   *  @retval std::size_t bytes of keys kept in memory, or zero for no limit
+   */
+  std::size_t budget() const;
+
+  /**
+   *  @brief Number of runs written since the last merge
+   *  @retval std::size_t number of runs on disk
+   */
+  std::size_t runs() const;
+};
+
+/**
+ *  @brief Parse a memory size such as 512M or 2G
+ *  @param text number of bytes, optionally followed by K, M or G
+ *  @param bytes receives the size in bytes
+ *  @retval bool false if the text is not a size or the size does not fit in
+ *          std::size_t
+ */
+bool parseSize(const std::string& text, std::size_t* bytes);
+
+}  // namespace bf
+
+#endif  // BIGFIX_SPILL_H_
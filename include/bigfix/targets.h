@@ -0,0 +1,64 @@
+/**
+ *  @file targets.h
+ *  @brief Parser for deployment target files
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_TARGETS_H_
+#define BIGFIX_TARGETS_H_
+
+#include <cstddef>
+#include <string>
+#include "bigfix/grouptable.h"
+
+namespace bf {
+
+/** character that starts a comment line in a target file */
+const char kComment {'#'};
+
+/**
+ *  @brief Parse a deployment target file held in memory
+ *  @details Each line holds a computer group name and its target count
+ *           separated by kDelim. Blank lines and lines starting with
+ *           kComment are skipped, line endings may be LF or CRLF, blanks
+ *           around fields are ignored, and names containing kDelim may be
+ *           quoted with doubled quotes for embedded quotes. A first line
+ *           whose target is not a number is taken as a header. Every
+ *           other malformed line is reported with its line number, and the
+ *           file as a whole is then rejected.
+ *  @param data contents of the file
+ *  @param length length of the file
+ *  @param filename name of the file, for error messages
+ *  @param final receives one computer group per valid line, in file order
+ *  @retval bool false if any line was malformed, in which case the file
+ *          must not be used
+ */
+bool parseTargets(const char* data, std::size_t length,
+                  const std::string& filename, GroupTable* final);
+
+}  // namespace bf
+
+#endif  // BIGFIX_TARGETS_H_
@@ -0,0 +1,229 @@
+/**
+ *  @file threadpool.h
+ *  @brief Work-stealing thread pool shared by all parallel stages
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_THREADPOOL_H_
+#define BIGFIX_THREADPOOL_H_
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace bf {
+
+/**
+ *  @brief Instrumentation gathered by one pool worker
+ */
+struct WorkerStats {
+  uint64_t tasks {0};        /**< tasks run by the worker */
+  uint64_t steals {0};       /**< tasks taken from another worker's queue */
+  std::size_t max_depth {0}; /**< longest the worker's queue has been */
+  double busy {0};           /**< seconds spent running tasks */
+  double idle {0};           /**< seconds spent waiting for tasks */
+};
+
+/**
+ *  @brief Number of workers to use when none is given
+ *  @retval std::size_t number of hardware threads, at least one
+ */
+std::size_t defaultThreads();
+
+/**
+ *  @brief Fixed set of worker threads with one task queue each
+ *  @details A worker runs tasks from the back of its own queue and, once it
+ *           is empty, steals from the front of the others', so a long file
+ *           on one worker does not leave the rest idle. Tasks submitted from
+ *           outside the pool are dealt round-robin; tasks submitted by a
+ *           task go to its own worker. Tasks must not block on each other:
+ *           stages that wait on I/O or a pipeline keep their own threads.
+ */
+class ThreadPool {
+ public:
+  /**
+   *  @brief A unit of work
+   *  @param worker index of the worker running the task, less than size()
+   */
+  typedef std::function<void(std::size_t worker)> Task;
+
+ private:
+  /**
+   *  @brief Queue, thread and counters of one worker
+   */
+  struct Worker {
+    std::deque<Task> tasks;
+    std::mutex mutex;
+    std::thread thread;
+    WorkerStats stats;
+    /** whether the worker is waiting for tasks, guarded by mutex_ */
+    bool asleep {false};
+    /** when the current wait began, guarded by mutex_ */
+    std::chrono::steady_clock::time_point since;
+  };
+
+  /**
+   *  @brief All workers, allocated separately so none share a cache line
+   */
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  /**
+   *  @brief Number of tasks waiting in any queue
+   */
+  std::atomic<std::size_t> queued_ {0};
+
+  /**
+   *  @brief Number of tasks submitted but not yet finished
+   */
+  std::atomic<std::size_t> pending_ {0};
+
+  /**
+   *  @brief Next queue for tasks submitted from outside the pool
+   */
+  std::atomic<std::size_t> next_ {0};
+
+  /**
+   *  @brief Set when the pool is being destroyed
+   */
+  bool stop_ {false};
+
+  /**
+   *  @brief Whether workers are pinned to CPUs
+   */
+  bool pinned_ {false};
+
+  /**
+   *  @brief Guards stop_ and the sleeping state of workers
+   */
+  std::mutex mutex_;
+
+  /**
+   *  @brief Signalled when a task is queued or the pool stops
+   */
+  std::condition_variable wake_;
+
+  /**
+   *  @brief Signalled when a task finishes
+   */
+  std::condition_variable done_;
+
+  /**
+   *  @brief Worker thread body
+   *  @param index index of the worker
+   */
+  void loop(std::size_t index);
+
+  /**
+   *  @brief Take a task from the worker's own queue or steal one
+   *  @param index index of the worker
+   *  @param task receives the task
+   *  @retval bool false if every queue was empty
+   */
+  bool take(std::size_t index, Task* task);
+
+  /**
+   *  @brief Pin a worker to one of the CPUs the process may run on
+   *  @param thread worker thread
+   *  @param index index of the worker, wrapping around the allowed CPUs
+   *  @retval bool false if the CPU could not be set
+   */
+  static bool pin(std::thread* thread, std::size_t index);
+
+ public:
+  /**
+   *  @brief Start the workers
+   *  @param threads number of workers, defaultThreads() if zero
+   *  @param affinity pin worker i to the i-th CPU the process may run on
+   */
+  explicit ThreadPool(std::size_t threads = 0, bool affinity = false);
+
+  /**
+   *  @brief Finish all queued tasks and stop the workers
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   *  @brief Number of workers
+   *  @retval std::size_t number of workers
+   */
+  std::size_t size() const;
+
+  /**
+   *  @brief Whether every worker was pinned to a CPU
+   *  @retval bool true if affinity was requested and could be set
+   */
+  bool pinned() const;
+
+  /**
+   *  @brief Queue a task
+   *  @param task task to run on some worker
+   */
+  void submit(Task task);
+
+  /**
+   *  @brief Block until few enough submitted tasks are unfinished
+   *  @details Must not be called from a task
+   *  @param limit number of unfinished tasks to wait for, 0 to wait for all
+   */
+  void wait(std::size_t limit = 0);
+
+  /**
+   *  @brief Run a task for each index and wait for all of them
+   *  @details Must not be called from a task
+   *  @param count number of tasks
+   *  @param body called with each index below count and the worker index
+   */
+  void run(std::size_t count,
+           const std::function<void(std::size_t index,
+                                    std::size_t worker)>& body);
+
+  /**
+   *  @brief Counters of each worker, best read once the pool is quiet
+   *  @retval std::vector<WorkerStats> one entry per worker
+   */
+  std::vector<WorkerStats> stats();
+
+  /**
+   *  @brief Zero the counters of each worker, best called while the pool is
+   *         quiet
+   */
+  void reset_stats();
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_THREADPOOL_H_
@@ -0,0 +1,219 @@
+/**
+ *  @file tokenizer.h
+ *  @brief Zero-copy helpers for scanning report table rows
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_TOKENIZER_H_
+#define BIGFIX_TOKENIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace bf {
+
+/**
+ *  @brief Contents of one table cell, pointing into the line it came from
+ */
+struct Cell {
+  /** first character of the cell contents */
+  const char* data;
+  /** number of characters in the cell */
+  std::size_t length;
+};
+
+struct HeaderSchema;
+struct UpperHeaderSchema;
+
+/**
+ *  @brief Web Reports table rows with lowercase tags
+ *  @details A schema names, as character arrays known at compile time, the
+ *           text that starts a row of interest and that opens and closes
+ *           each cell. Row parsers are templates over a schema, so each tag
+ *           is matched with a comparison of fixed length.
+ */
+struct HtmlSchema {
+  /** schema of the header rows of the same table */
+  typedef HeaderSchema Header;
+  /** text that indicates a line contains our records */
+  static constexpr char kRecord[] = "<tr>";
+  /** text that indicates the start of a record */
+  static constexpr char kStart[] = "<td>";
+  /** text that indicates the end of a record */
+  static constexpr char kEnd[] = "</td>";
+};
+
+/**
+ *  @brief Table rows with uppercase tags, as written by older exports
+ */
+struct UpperHtmlSchema {
+  /** schema of the header rows of the same table */
+  typedef UpperHeaderSchema Header;
+  /** text that indicates a line contains our records */
+  static constexpr char kRecord[] = "<TR>";
+  /** text that indicates the start of a record */
+  static constexpr char kStart[] = "<TD>";
+  /** text that indicates the end of a record */
+  static constexpr char kEnd[] = "</TD>";
+};
+
+/**
+ *  @brief Table header rows naming each column
+ */
+struct HeaderSchema {
+  /** schema of the header rows of the same table */
+  typedef HeaderSchema Header;
+  /** text that indicates a line contains our records */
+  static constexpr char kRecord[] = "<tr>";
+  /** text that indicates the start of a record */
+  static constexpr char kStart[] = "<th>";
+  /** text that indicates the end of a record */
+  static constexpr char kEnd[] = "</th>";
+};
+
+/**
+ *  @brief Table header rows with uppercase tags
+ */
+struct UpperHeaderSchema {
+  /** schema of the header rows of the same table */
+  typedef UpperHeaderSchema Header;
+  /** text that indicates a line contains our records */
+  static constexpr char kRecord[] = "<TR>";
+  /** text that indicates the start of a record */
+  static constexpr char kStart[] = "<TH>";
+  /** text that indicates the end of a record */
+  static constexpr char kEnd[] = "</TH>";
+};
+
+/**
+ *  @brief Whether a tag occurs at a given position
+ *  @param data position to compare, with at least N - 1 characters available
+ *  @param tag text to compare, as a string literal or constexpr array
+ *  @retval bool true if data starts with tag
+ */
+template <std::size_t N>
+inline bool matchTag(const char* data, const char (&tag)[N]) {
+  static_assert(N > 1, "tags must not be empty");
+  return memcmp(data, tag, N - 1) == 0;
+}
+
+/**
+ *  @brief Find a tag within a line without copying either
+ *  @details Candidates are located by their first character with memchr and
+ *           confirmed with a comparison whose length is a constant
+ *  @param data start of the line
+ *  @param length length of the line
+ *  @param pos position to start searching from, possibly std::string::npos
+ *  @param tag text to find, as a string literal or constexpr array
+ *  @retval std::size_t position of tag, or std::string::npos if not found
+ */
+template <std::size_t N>
+inline std::size_t findTag(const char* data, std::size_t length,
+                           std::size_t pos, const char (&tag)[N]) {
+  const std::size_t size {N - 1};
+  if (pos >= length || length - pos < size) {
+    return std::string::npos;
+  }
+  const std::size_t last = length - size;
+  while (pos <= last) {
+    const char* hit = static_cast<const char*>(
+        memchr(data + pos, tag[0], last - pos + 1));
+    if (hit == nullptr) {
+      break;
+    }
+    pos = static_cast<std::size_t>(hit - data);
+    if (matchTag(data + pos, tag)) {
+      return pos;
+    }
+    ++pos;
+  }
+  return std::string::npos;
+}
+
+/**
+ *  @brief Whether a line starts a row of a schema
+ *  @param line start of the line
+ *  @param length length of the line
+ *  @retval bool true if the line begins with Schema::kRecord
+ */
+template <typename Schema>
+inline bool isRecord(const char* line, std::size_t length) {
+  return length >= sizeof(Schema::kRecord) - 1 &&
+         matchTag(line, Schema::kRecord);
+}
+
+/**
+ *  @brief Whether a report writes its table tags in uppercase
+ *  @param data report contents, or a prefix of them
+ *  @param length length of data
+ *  @retval bool true if the first row starts with UpperHtmlSchema::kRecord
+ */
+bool isUpperCase(const char* data, std::size_t length);
+
+/**
+ *  @brief Parse a decimal number in place, skipping leading whitespace
+ *  @param data first character of the number
+ *  @param length number of characters available
+ *  @param value receives the parsed number, 0 if there are no digits or
+ *         the number does not fit
+ *  @retval bool true if at least one digit was found and the number fits in
+ *          uint32_t
+ */
+bool parseNumber(const char* data, std::size_t length, uint32_t* value);
+
+/**
+ *  @brief Split a table row into the contents of its kStart/kEnd cells
+ *  @details Instantiated for every schema
+ *  @param line start of the line
+ *  @param length length of the line
+ *  @param cells receives one entry per complete cell, in order
+ */
+template <typename Schema>
+void splitCells(const char* line, std::size_t length, std::vector<Cell>* cells);
+
+/**
+ *  @brief Find only the cells of a table row at the given column indexes
+ *  @details Cells before the last wanted one are skipped by jumping from
+ *           each kStart to the next kEnd; nothing is stored for them, and
+ *           the rest of the row is not scanned at all. Instantiated for
+ *           HtmlSchema and UpperHtmlSchema.
+ *  @param line start of the line
+ *  @param length length of the line
+ *  @param columns zero-based index of each wanted cell
+ *  @param count number of wanted cells
+ *  @param cells receives the wanted cells, in the order of columns
+ *  @retval bool false if the row has fewer cells than needed
+ */
+template <typename Schema>
+bool selectCells(const char* line, std::size_t length,
+                 const std::size_t* columns, std::size_t count, Cell* cells);
+
+}  // namespace bf
+
+#endif  // BIGFIX_TOKENIZER_H_
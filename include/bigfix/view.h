@@ -0,0 +1,216 @@
+/**
+ *  @file view.h
+ *  @brief Selection of the computer groups and rows shown in the output
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef BIGFIX_VIEW_H_
+#define BIGFIX_VIEW_H_
+
+#include <regex.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+class GroupTable;
+
+namespace bf {
+
+/**
+ *  @brief Rows of the output tables, combined as a bit mask
+ */
+enum Row : unsigned {
+  kRawRow = 1,      /**< the dated row of raw counts */
+  kCurrentRow = 2,  /**< number of computers in each group */
+  kTargetRow = 4,   /**< number of computers expected in each group */
+  kPercentRow = 8   /**< deployment percentage of each group */
+};
+
+/** every row of the output tables */
+const unsigned kAllRows {kRawRow | kCurrentRow | kTargetRow | kPercentRow};
+
+/** rows of the computer group table, which is left out if none is shown */
+const unsigned kGroupRows {kCurrentRow | kTargetRow | kPercentRow};
+
+/** default number of computer groups in each Confluence table */
+const std::size_t kPageColumns {200};
+
+/**
+ *  @brief Orders in which computer groups can be displayed
+ */
+enum class SortKey {
+  kNone,     /**< target file order */
+  kPercent,  /**< deployment percentage */
+  kCurrent,  /**< number of computers in the group */
+  kTarget,   /**< number of computers expected in the group */
+  kGap       /**< computers still missing, target less current */
+};
+
+/**
+ *  @brief Which computer groups and rows the output tables show
+ *  @details Group patterns are matched once per interned name, so selecting
+ *           the groups of a table is a pass over integer identifiers and only
+ *           the chosen groups are ever formatted. Top and bottom selections
+ *           partially order the sort keys instead of sorting every group.
+ *           The TOTAL group is always shown and still counts every group.
+ */
+class View {
+ private:
+  /**
+   *  @brief Shell wildcard patterns, as accepted by fnmatch()
+   */
+  std::vector<std::string> globs_;
+
+  /**
+   *  @brief Compiled extended regular expressions
+   */
+  std::vector<std::shared_ptr<regex_t>> patterns_;
+
+  /**
+   *  @brief Rows to show, a combination of Row values
+   */
+  unsigned rows_ {kAllRows};
+
+  /**
+   *  @brief Order in which to display computer groups
+   */
+  SortKey sort_ {SortKey::kNone};
+
+  /**
+   *  @brief Number of computer groups to display, or zero for all of them
+   */
+  std::size_t limit_ {0};
+
+  /**
+   *  @brief Whether to display the lowest rather than the highest groups
+   */
+  bool bottom_ {false};
+
+  /**
+   *  @brief Computer groups per Confluence table, or zero for one table
+   */
+  std::size_t page_ {kPageColumns};
+
+  /**
+   *  @brief Whether to display one computer group per line
+   */
+  bool transposed_ {false};
+
+ public:
+  /**
+   *  @brief Restrict the output to groups matching any of several patterns
+   *  @details Patterns are separated by commas; a pattern enclosed in slashes
+   *           is an extended regular expression, anything else a wildcard
+   *  @param patterns comma-separated list of patterns
+   *  @retval bool false if a regular expression is invalid
+   */
+  bool set_groups(const std::string& patterns);
+
+  /**
+   *  @brief Restrict the output to some rows
+   *  @param rows comma-separated list of raw, current, target and comp
+   *  @retval bool false if a row name is not recognized
+   */
+  bool set_rows(const std::string& rows);
+
+  /**
+   *  @brief Sort computer groups, highest first
+   *  @param key one of percent, current, target or gap
+   *  @retval bool false if the sort key is not recognized
+   */
+  bool set_sort(const std::string& key);
+
+  /**
+   *  @brief Display only the highest computer groups in the sort order
+   *  @details Groups are ranked by percentage if no sort key was set
+   *  @param count number of computer groups to display
+   */
+  void set_top(std::size_t count);
+
+  /**
+   *  @brief Display only the lowest computer groups, lowest first
+   *  @details Groups are ranked by percentage if no sort key was set
+   *  @param count number of computer groups to display
+   */
+  void set_bottom(std::size_t count);
+
+  /**
+   *  @brief Split wide Confluence tables into several narrower ones
+   *  @param columns computer groups per table, or zero for a single table
+   */
+  void set_page(std::size_t columns);
+
+  /**
+   *  @brief Accessor method for the page_ property
+   *  @retval std::size_t computer groups per table, or zero for one table
+   */
+  std::size_t page() const;
+
+  /**
+   *  @brief Display one computer group per line instead of per column
+   *  @param transposed true for one computer group per line
+   */
+  void set_transposed(bool transposed);
+
+  /**
+   *  @brief Accessor method for the transposed_ property
+   *  @retval bool true to display one computer group per line
+   */
+  bool transposed() const;
+
+  /**
+   *  @brief Whether a row is shown
+   *  @param row row of the output tables
+   *  @retval bool true if the row was selected
+   */
+  bool shows(Row row) const;
+
+  /**
+   *  @brief Accessor method for the rows_ property
+   *  @retval unsigned rows to show, a combination of Row values
+   */
+  unsigned rows() const;
+
+  /**
+   *  @brief Whether a computer group is shown
+   *  @param name computer group name
+   *  @retval bool true if no patterns were given or one matches
+   */
+  bool matches(const std::string& name) const;
+
+  /**
+   *  @brief Rows of a group table to show, in display order
+   *  @details TOTAL rows are never ranked and always come last
+   *  @param table finalized computer groups
+   *  @retval std::vector<std::size_t> selected row indices
+   */
+  std::vector<std::size_t> select(GroupTable* table) const;
+};
+
+}  // namespace bf
+
+#endif  // BIGFIX_VIEW_H_
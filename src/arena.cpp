@@ -0,0 +1,81 @@
+/**
+ *  @file arena.cpp
+ *  @brief Monotonic arena for transient per-report parse allocations
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <memory>
+#include "bigfix/arena.h"
+
+bf::Arena::Arena(std::size_t block_size) : block_size_(block_size) {
+}
+
+/**
+ *  @details Move on to the next retained block when the current one is full,
+ *           allocating a new block only when none of the retained ones is left
+ *           or the next one is too small for this request
+ */
+void* bf::Arena::allocate(std::size_t bytes, std::size_t align) {
+  while (block_ < blocks_.size()) {
+    std::size_t start = (used_ + align - 1) & ~(align - 1);
+    if (start + bytes <= sizes_[block_]) {
+      used_ = start + bytes;
+      return blocks_[block_].get() + start;
+    }
+    if (used_ == 0 && bytes > sizes_[block_]) {
+      break;
+    }
+    ++block_;
+    used_ = 0;
+  }
+  std::size_t size = bytes + align > block_size_ ? bytes + align : block_size_;
+  std::unique_ptr<char[]> block(new char[size]);
+  char* base = block.get();
+  blocks_.insert(blocks_.begin() + block_, std::move(block));
+  sizes_.insert(sizes_.begin() + block_, size);
+  std::size_t start = (align - reinterpret_cast<std::size_t>(base) % align) %
+                      align;
+  used_ = start + bytes;
+  return base + start;
+}
+
+void bf::Arena::reset() {
+  block_ = 0;
+  used_ = 0;
+}
+
+std::size_t bf::Arena::capacity() const {
+  std::size_t total {0};
+  for (auto size : sizes_) {
+    total += size;
+  }
+  return total;
+}
+
+bf::Arena& bf::Arena::local() {
+  static thread_local Arena arena;
+  return arena;
+}
@@ -0,0 +1,272 @@
+/**
+ *  @file besapi.cpp
+ *  @brief Parser for BigFix REST API relevance query results
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include "bigfix/besapi.h"
+#include "bigfix/input.h"
+#include "bigfix/output.h"
+#include "bigfix/tokenizer.h"
+
+namespace {
+
+constexpr char kTuple[] = "<Tuple>";
+constexpr char kTupleEnd[] = "</Tuple>";
+constexpr char kAnswer[] = "<Answer";
+constexpr char kAnswerEnd[] = "</Answer>";
+constexpr char kError[] = "<Error>";
+constexpr char kErrorEnd[] = "</Error>";
+constexpr char kResultEnd[] = "</Result>";
+constexpr char kInteger[] = "type=\"integer\"";
+
+/**
+ *  @brief Append a code point as UTF-8
+ *  @param code Unicode code point
+ *  @param out string to append to
+ */
+void putUtf8(uint32_t code, std::string* out) {
+  if (code < 0x80) {
+    out->push_back(static_cast<char>(code));
+  } else if (code < 0x800) {
+    out->push_back(static_cast<char>(0xc0 | (code >> 6)));
+    out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+  } else if (code < 0x10000) {
+    out->push_back(static_cast<char>(0xe0 | (code >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+  } else {
+    out->push_back(static_cast<char>(0xf0 | (code >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3f)));
+    out->push_back(static_cast<char>(0x80 | (code & 0x3f)));
+  }
+}
+
+/**
+ *  @brief Copy XML character data, replacing entity and character references
+ *  @param data start of the text
+ *  @param length length of the text
+ *  @retval std::string decoded text
+ */
+std::string unescape(const char* data, std::size_t length) {
+  static const struct {
+    const char* name;
+    char c;
+  } entities[] {{"amp;", '&'}, {"lt;", '<'}, {"gt;", '>'}, {"quot;", '"'},
+                {"apos;", '\''}};
+  std::string text;
+  text.reserve(length);
+  for (std::size_t i = 0; i < length; ++i) {
+    if (data[i] != '&') {
+      text.push_back(data[i]);
+      continue;
+    }
+    std::size_t semi = i + 1;
+    while (semi < length && data[semi] != ';' && semi - i < 12) {
+      ++semi;
+    }
+    std::string ref(data + i + 1, semi < length ? semi - i : 0);
+    bool found {false};
+    for (const auto& entity : entities) {
+      if (ref == entity.name) {
+        text.push_back(entity.c);
+        found = true;
+      }
+    }
+    if (!found && ref.length() > 2 && ref[0] == '#') {
+      bool hex = (ref[1] == 'x' || ref[1] == 'X');
+      char* end {nullptr};
+      uint32_t code = static_cast<uint32_t>(
+          strtoul(ref.c_str() + (hex ? 2 : 1), &end, hex ? 16 : 10));
+      found = (*end == ';' && code <= 0x10ffff);
+      if (found) {
+        putUtf8(code, &text);
+      }
+    }
+    if (found) {
+      i = semi;
+    } else {
+      // not a reference, keep the ampersand as it was
+      text.push_back('&');
+    }
+  }
+  return text;
+}
+
+/**
+ *  @brief Convert one tuple to a computer group name and count
+ *  @details The count is the first Answer typed as an integer and the name
+ *           the first other Answer; untyped tuples are read as (name, count)
+ *  @param data start of the tuple contents
+ *  @param length length of the tuple contents
+ *  @param raw receives the count of the computer group; like the other
+ *         report formats, the first count of a repeated group is kept
+ */
+void parseTuple(const char* data, std::size_t length,
+                std::map<std::string, uint32_t>* raw) {
+  const char* name {nullptr};
+  std::size_t name_length {0};
+  uint32_t count {0};
+  bool counted {false};
+  std::size_t start = bf::findTag(data, length, 0, kAnswer);
+  while (start != std::string::npos) {
+    std::size_t open = bf::findTag(data, length, start, ">");
+    if (open == std::string::npos) {
+      break;
+    }
+    bool integer = bf::findTag(data, open, start, kInteger) !=
+                   std::string::npos;
+    std::size_t first = open + 1, last = first;
+    if (data[open - 1] != '/') {
+      last = bf::findTag(data, length, first, kAnswerEnd);
+      if (last == std::string::npos) {
+        break;
+      }
+    }
+    if (!counted && (integer || name != nullptr)) {
+      counted = bf::parseNumber(data + first, last - first, &count);
+    } else if (name == nullptr) {
+      name = data + first;
+      name_length = last - first;
+    }
+    start = bf::findTag(data, length, last, kAnswer);
+  }
+  if (name != nullptr && counted) {
+    raw->emplace(unescape(name, name_length), count);
+  }
+}
+
+}  // namespace
+
+/**
+ *  @details Walks the text one '<' at a time and looks only at the tag found
+ *           there, so each character is examined a bounded number of times
+ *           however many tuples follow; a tag too short to tell apart, or an
+ *           element whose end has not arrived, is left for the next call
+ */
+std::size_t bf::QueryParser::scan(const char* data, std::size_t length,
+                                  std::map<std::string, uint32_t>* raw) {
+  std::size_t pos {0};
+  while (!complete_ && error_.empty() && pos < length) {
+    const char* hit = static_cast<const char*>(
+        memchr(data + pos, '<', length - pos));
+    if (hit == nullptr) {
+      break;
+    }
+    std::size_t tag = static_cast<std::size_t>(hit - data);
+    if (length - tag < sizeof(kResultEnd) - 1) {
+      return tag;
+    }
+    if (matchTag(hit, kResultEnd)) {
+      complete_ = true;
+    } else if (matchTag(hit, kError)) {
+      std::size_t close = findTag(data, length, tag, kErrorEnd);
+      if (close == std::string::npos) {
+        return tag;
+      }
+      tag += sizeof(kError) - 1;
+      error_ = unescape(data + tag, close - tag);
+    } else if (matchTag(hit, kTuple)) {
+      std::size_t close = findTag(data, length, tag, kTupleEnd);
+      if (close == std::string::npos) {
+        return tag;
+      }
+      tag += sizeof(kTuple) - 1;
+      parseTuple(data + tag, close - tag, raw);
+      pos = close + sizeof(kTupleEnd) - 1;
+      continue;
+    }
+    pos = tag + 1;
+  }
+  return length;
+}
+
+void bf::QueryParser::feed(const char* data, std::size_t length,
+                           std::map<std::string, uint32_t>* raw) {
+  if (complete_ || !error_.empty()) {
+    return;
+  }
+  if (pending_.empty()) {
+    std::size_t used = scan(data, length, raw);
+    pending_.assign(data + used, length - used);
+  } else {
+    pending_.append(data, length);
+    pending_.erase(0, scan(pending_.data(), pending_.length(), raw));
+  }
+}
+
+bool bf::QueryParser::complete() const {
+  return complete_;
+}
+
+const std::string& bf::QueryParser::error() const {
+  return error_;
+}
+
+bool bf::isQuery(const std::string& filename) {
+  std::string name = uncompressedName(filename);
+  return name.length() > kXmlExt.length() &&
+         name.compare(name.length() - kXmlExt.length(), kXmlExt.length(),
+                      kXmlExt) == 0;
+}
+
+bool bf::parseQuery(const char* data, std::size_t length,
+                    std::map<std::string, uint32_t>* raw) {
+  QueryParser parser;
+  parser.feed(data, length, raw);
+  return parser.complete();
+}
+
+bool bf::loadQuery(const std::string& filename,
+                   std::map<std::string, uint32_t>* raw) {
+  Input fs(filename);
+  if (!fs.is_open()) {
+    message("Error: Could not open file %s\n", filename.c_str());
+    return false;
+  }
+  QueryParser parser;
+  std::string line {};
+  while (fs.getline(&line)) {
+    line.push_back('\n');
+    parser.feed(line.data(), line.length(), raw);
+  }
+  if (!parser.error().empty()) {
+    message("Error: Query in %s failed: %s\n", filename.c_str(),
+            parser.error().c_str());
+    return false;
+  }
+  if (fs.failed() || !parser.complete()) {
+    message("Error: File %s is truncated or corrupt\n", filename.c_str());
+    return false;
+  }
+  return true;
+}
@@ -27,107 +27,115 @@
  * SOFTWARE.
  */
 
+#include <sys/stat.h>
 #include <algorithm>
-#include <cmath>
-#include <fstream>  // NOLINT
+#include <cctype>
+#include <cerrno>
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
+#include "bigfix/arena.h"
+#include "bigfix/besapi.h"
 #include "bigfix/bigfixstats.h"
+#include "bigfix/cache.h"
+#include "bigfix/counters.h"
+#include "bigfix/daemon.h"
+#include "bigfix/endpoints.h"
+#include "bigfix/input.h"
+#include "bigfix/join.h"
+#include "bigfix/mappedfile.h"
+#include "bigfix/readengine.h"
+#include "bigfix/spill.h"
+#include "bigfix/targets.h"
+#include "bigfix/threadpool.h"
+#include "bigfix/tokenizer.h"
 
-ComputerGroup::ComputerGroup() {
-}
-
-ComputerGroup::ComputerGroup(const std::string name) {
-  name_ = name;
-}
-
-uint8_t ComputerGroup::widest() const {
-  uint8_t top {0};
-  uint8_t name = name_.length();
-  uint8_t current = bf::format(current_).length();
-  uint8_t target = bf::format(target_).length();
-  uint8_t percent = bf::format(this->percent()).length() + 2;
-  std::vector<uint8_t> vector = {name, current, target, percent};
-  for (auto it : vector) {
-    if (it > top) {
-      top = it;
+/**
+ *  @details format the supplied number into comma-separated groupings since
+ *           there apparently is no portable way of doing this
+ */
+std::string bf::format(const uint32_t number) {
+  std::string output = std::to_string(number);
+  if (output.length() > 3) {
+    for (int i = static_cast<int>(output.length() - 3); i > 0; i -= 3) {
+      output.insert(i, ",");
     }
   }
-  return top;
-}
-
-std::string ComputerGroup::name() const {
-  return name_;
+  return output;
 }
 
-std::string ComputerGroup::formatted_name() const {
-  std::string ret;
-  if (name_ == "OS") {
-    ret = name_ + "*" + std::string(this->widest() - name_.length() - 1, ' ');
-  } else {
-    ret = name_ + std::string(this->widest() - name_.length(), ' ');
+/**
+ *  @details The date sits just before the extension, after any compression
+ *           suffix has been removed
+ */
+std::string bf::date(const std::string& filename) {
+  std::string name = bf::uncompressedName(filename);
+  std::size_t ext = kExt.length();
+  if (reportFormat(name) == ReportFormat::kQuery) {
+    ext = kXmlExt.length();
+  } else if (reportFormat(name) == ReportFormat::kCsv) {
+    ext = kCsvExt.length();
   }
-  return ret;
-}
-
-uint32_t ComputerGroup::current() const {
-  return current_;
-}
-
-std::string ComputerGroup::formatted_current() const {
-  std::string output = bf::format(current_);
-  return output + std::string(this->widest() - output.length() + 1, ' ');
-}
-
-uint32_t ComputerGroup::target() const {
-  return target_;
-}
-
-std::string ComputerGroup::formatted_target() const {
-  std::string output = bf::format(target_);
-  return output + std::string(this->widest() - output.length() + 1, ' ');
-}
-
-uint8_t ComputerGroup::percent() const {
-  if (target_ != 0) {
-    return round(static_cast<double>(current_) / target_ * 100);
-  } else {
-    return 0;
+  if (name.length() < ext + kDate.length()) {
+    return name;
   }
+  size_t begin = name.length() - ext - kDate.length();
+  return name.substr(begin, kDate.length());
 }
 
-std::string ComputerGroup::formatted_percent() const {
-  std::string output = "*" + std::to_string(this->percent()) + "*";
-  return output + std::string(this->widest() - output.length() + 1, ' ');
-}
-
-void ComputerGroup::set_name(std::string name) {
-  name_ = name;
-}
-
-void ComputerGroup::set_current(uint32_t current) {
-  current_ = current;
-}
-
-void ComputerGroup::set_target(uint32_t target) {
-  target_ = target;
+bf::ReportFormat bf::reportFormat(const std::string& filename) {
+  if (isQuery(filename)) {
+    return ReportFormat::kQuery;
+  }
+  if (isCsv(filename)) {
+    return ReportFormat::kCsv;
+  }
+  return ReportFormat::kHtml;
 }
 
 /**
- *  @details format the supplied number into comma-separated groupings since
- *           there apparently is no portable way of doing this
+ *  @details Replace the characters that are special in HTML text and
+ *           attribute values
  */
-std::string bf::format(const uint32_t number) {
-  std::string output = std::to_string(number);
-  if (output.length() > 3) {
-    for (int i = static_cast<int>(output.length() - 3); i > 0; i -= 3) {
-      output.insert(i, ",");
+std::string bf::escape(const std::string& text) {
+  std::string output {};
+  for (char c : text) {
+    switch (c) {
+      case '&': output += "&amp;"; break;
+      case '<': output += "&lt;"; break;
+      case '>': output += "&gt;"; break;
+      case '"': output += "&quot;"; break;
+      default: output += c;
     }
   }
   return output;
 }
 
+/**
+ *  @details strtoull() accepts leading spaces and a minus sign, so the first
+ *           character is checked to be a digit before converting
+ */
+bool bf::parseNumber(const std::string& text, std::size_t* number) {
+  if (text.empty() || !isdigit(static_cast<unsigned char>(text[0]))) {
+    return false;
+  }
+  char* end = nullptr;
+  errno = 0;
+  unsigned long long value = strtoull(text.c_str(), &end, 10);  // NOLINT
+  if (*end != '\0' || errno == ERANGE ||
+      value > std::numeric_limits<std::size_t>::max()) {
+    return false;
+  }
+  *number = static_cast<std::size_t>(value);
+  return true;
+}
+
 /**
  *  @brief Converts BigFix deployment reports into text for updating Atlassian 
  *         Confluence tables
@@ -142,24 +150,74 @@ int main(int argc, const char * argv[]) {
   for (int i = 1; i < argc; ++i) {
     args.push_back(argv[i]);
   }
+  // use --serve to answer requests from a warm cache until killed
+  it = std::find(args.begin(), args.end(), "--serve");
+  if (it != args.end()) {
+    if (next(it) == args.end()) {
+      printf("%s: option --serve requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    std::string socket = *next(it);
+    std::size_t entries {bf::kCacheEntries};
+    it = std::find(args.begin(), args.end(), "--cache");
+    if (it != args.end() &&
+        (next(it) == args.end() || !bf::parseNumber(*next(it), &entries) ||
+         entries == 0)) {
+      printf("%s: option --cache requires a number\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    WarmCache cache(entries);
+    return bf::serve(socket, [&cache](const std::vector<std::string>& request) {
+      return run(request, &cache);
+    }) ? 0 : 1;
+  }
+  // use --connect to have a daemon started with --serve produce the report
+  it = std::find(args.begin(), args.end(), "--connect");
+  if (it != args.end()) {
+    if (next(it) == args.end()) {
+      printf("%s: option --connect requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    std::string socket = *next(it);
+    args.erase(it, it + 2);
+    return bf::callDaemon(socket, args);
+  }
+  return run(args);
+}
+
+/**
+ *  @details Every option is read from args; with a cache, target files and
+ *           reports parsed by earlier requests are reused while unchanged
+ */
+int run(std::vector<std::string> args, WarmCache* cache) {
+  std::vector<std::string>::iterator it;
   // display -h help
   it = std::find(args.begin(), args.end(), "-h");
-  if ((argc == 1) || (it != args.end())) {
+  if (args.empty() || (it != args.end())) {
     usage();
     return 0;
   }
-  // use -c current file
-  std::string current_file {};
+  // use -c current files, which may be repeated to sum several servers
+  std::vector<std::string> current_files {};
   it = std::find(args.begin(), args.end(), "-c");
-  if (it != args.end()) {
+  while (it != args.end()) {
     if (next(it) != args.end()) {
-      current_file = *next(it);
+      current_files.push_back(*next(it));
     } else {
       printf("%s: option -c requires an argument\n", bf::kProgramName.c_str());
       usage();
       return 1;
     }
+    it = std::find(next(it), args.end(), "-c");
   }
+  // use --sources to break down summed counts by current file
+  bool sources = std::find(args.begin(), args.end(), "--sources") != args.end();
   // use -t target file
   std::string target_file {};
   it = std::find(args.begin(), args.end(), "-t");
@@ -172,138 +230,1374 @@ int main(int argc, const char * argv[]) {
       return 1;
     }
   }
+  // use -b batch directory
+  std::string batch_dir {};
+  it = std::find(args.begin(), args.end(), "-b");
+  if (it != args.end()) {
+    if (next(it) != args.end()) {
+      batch_dir = *next(it);
+    } else {
+      printf("%s: option -b requires an argument\n", bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  // use -q reads in flight
+  std::size_t depth {bf::kReadDepth};
+  it = std::find(args.begin(), args.end(), "-q");
+  if (it != args.end()) {
+    if (next(it) == args.end() || !bf::parseNumber(*next(it), &depth)) {
+      printf("%s: option -q requires a number\n", bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  // use -j worker threads for all parallel work
+  std::size_t jobs {0};
+  it = std::find(args.begin(), args.end(), "-j");
+  if (it != args.end()) {
+    if (next(it) == args.end() || !bf::parseNumber(*next(it), &jobs)) {
+      printf("%s: option -j requires a number\n", bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  // use --affinity to pin each worker thread to its own CPU
+  bool affinity =
+      std::find(args.begin(), args.end(), "--affinity") != args.end();
+  // use --stats to report what each worker thread did
+  bool stats = std::find(args.begin(), args.end(), "--stats") != args.end();
+  // a daemon keeps its workers for as long as requests ask for the same ones
+  std::unique_ptr<bf::ThreadPool> own_pool;
+  std::unique_ptr<bf::ThreadPool>* workers = &own_pool;
+  std::size_t threads = jobs > 0 ? jobs : bf::defaultThreads();
+  if (cache != nullptr) {
+    workers = &cache->pool;
+    if (*workers != nullptr &&
+        ((*workers)->size() != threads || cache->affinity != affinity)) {
+      workers->reset();
+    }
+    cache->affinity = affinity;
+  }
+  if (*workers == nullptr) {
+    workers->reset(new bf::ThreadPool(threads, affinity));
+  }
+  bf::ThreadPool& pool = **workers;
+  pool.reset_stats();
+  if (affinity && !pool.pinned()) {
+    printf("Warning: Could not pin worker threads to CPUs\n");
+  }
+  // use --bench-counters to compare concurrent group counting strategies
+  if (std::find(args.begin(), args.end(), "--bench-counters") != args.end()) {
+    benchCounters(&pool);
+    if (stats) {
+      printStats(&pool);
+    }
+    return 0;
+  }
+  // use -e per-endpoint files, which may be repeated
+  std::vector<std::string> endpoint_files {};
+  it = std::find(args.begin(), args.end(), "-e");
+  while (it != args.end()) {
+    if (next(it) != args.end()) {
+      endpoint_files.push_back(*next(it));
+    } else {
+      printf("%s: option -e requires an argument\n", bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    it = std::find(next(it), args.end(), "-e");
+  }
+  // use --emit-partial to save a partial aggregate instead of displaying
+  std::string partial_file {};
+  it = std::find(args.begin(), args.end(), "--emit-partial");
+  if (it != args.end()) {
+    if (next(it) != args.end()) {
+      partial_file = *next(it);
+    } else {
+      printf("%s: option --emit-partial requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  // use --emit-catalog to generate the compiled-in group catalogue
+  std::string catalog_file {};
+  it = std::find(args.begin(), args.end(), "--emit-catalog");
+  if (it != args.end()) {
+    if (next(it) != args.end()) {
+      catalog_file = *next(it);
+    } else {
+      printf("%s: option --emit-catalog requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  // use --merge partial aggregates, every argument up to the next option;
+  // --merge may be repeated
+  std::vector<std::string> merge_files {};
+  it = std::find(args.begin(), args.end(), "--merge");
+  while (it != args.end()) {
+    std::size_t listed = merge_files.size();
+    for (++it; it != args.end() && it->compare(0, 1, "-") != 0; ++it) {
+      merge_files.push_back(*it);
+    }
+    if (merge_files.size() == listed) {
+      printf("%s: option --merge requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    it = std::find(it, args.end(), "--merge");
+  }
+  // use --approx to sketch endpoint groups instead of counting exactly
+  bool approximate =
+      std::find(args.begin(), args.end(), "--approx") != args.end();
+  // use --count to count computers in a combination of groups
+  std::string expression {};
+  it = std::find(args.begin(), args.end(), "--count");
+  if (it != args.end()) {
+    if (next(it) != args.end()) {
+      expression = *next(it);
+    } else {
+      printf("%s: option --count requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  // use --max-memory to spill endpoint memberships to disk past a limit
+  std::size_t budget {0};
+  it = std::find(args.begin(), args.end(), "--max-memory");
+  if (it != args.end()) {
+    if (next(it) == args.end() || !bf::parseSize(*next(it), &budget) ||
+        budget == 0) {
+      printf("%s: option --max-memory requires a size such as 512M\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  // use --bands to color percentages by deployment band
+  uint16_t amber {bf::kAmberPercent}, green {bf::kGreenPercent};
+  it = std::find(args.begin(), args.end(), "--bands");
+  bool banded = (it != args.end());
+  if (banded) {
+    std::size_t delim = std::string::npos, low {0}, high {0};
+    if (next(it) != args.end()) {
+      delim = next(it)->find(bf::kDelim);
+    }
+    if (delim == std::string::npos ||
+        !bf::parseNumber(next(it)->substr(0, delim), &low) ||
+        !bf::parseNumber(next(it)->substr(delim + 1), &high) ||
+        low > 100 || high > 100) {
+      printf("%s: option --bands requires an argument amber,green\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    amber = static_cast<uint16_t>(low);
+    green = static_cast<uint16_t>(high);
+  }
+  // use --group-column and --count-column to pick report columns
+  bf::ReportColumns columns;
+  it = std::find(args.begin(), args.end(), "--group-column");
+  if (it != args.end()) {
+    if (next(it) != args.end()) {
+      columns.group = *next(it);
+    } else {
+      printf("%s: option --group-column requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  it = std::find(args.begin(), args.end(), "--count-column");
+  if (it != args.end()) {
+    if (next(it) != args.end()) {
+      columns.count = *next(it);
+    } else {
+      printf("%s: option --count-column requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  // use --groups and --rows to display only some groups and rows
+  bf::View view;
+  it = std::find(args.begin(), args.end(), "--groups");
+  if (it != args.end()) {
+    if (next(it) == args.end()) {
+      printf("%s: option --groups requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    if (!view.set_groups(*next(it))) {
+      return 1;
+    }
+  }
+  it = std::find(args.begin(), args.end(), "--rows");
+  if (it != args.end()) {
+    if (next(it) == args.end()) {
+      printf("%s: option --rows requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    if (!view.set_rows(*next(it))) {
+      return 1;
+    }
+  }
+  // use --sort, --top and --bottom to rank the displayed groups
+  it = std::find(args.begin(), args.end(), "--sort");
+  if (it != args.end()) {
+    if (next(it) == args.end()) {
+      printf("%s: option --sort requires an argument\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    if (!view.set_sort(*next(it))) {
+      return 1;
+    }
+  }
+  const std::string limits[] {"--top", "--bottom"};
+  for (const auto& limit : limits) {
+    it = std::find(args.begin(), args.end(), limit);
+    if (it == args.end()) {
+      continue;
+    }
+    std::size_t count {0};
+    if (next(it) == args.end() || !bf::parseNumber(*next(it), &count)) {
+      printf("%s: option %s requires a number\n",
+             bf::kProgramName.c_str(), limit.c_str());
+      usage();
+      return 1;
+    }
+    if (limit == "--top") {
+      view.set_top(count);
+    } else {
+      view.set_bottom(count);
+    }
+  }
+  // use --page and --transpose to lay out wide Confluence tables
+  it = std::find(args.begin(), args.end(), "--page");
+  if (it != args.end()) {
+    std::size_t page {0};
+    if (next(it) == args.end() || !bf::parseNumber(*next(it), &page)) {
+      printf("%s: option --page requires a number\n",
+             bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+    view.set_page(page);
+  }
+  view.set_transposed(std::find(args.begin(), args.end(), "--transpose") !=
+                      args.end());
+  // use --join to list matched, target-only and report-only groups
+  bool joined = std::find(args.begin(), args.end(), "--join") != args.end();
+  // use --html to produce HTML tables
+  bool html = std::find(args.begin(), args.end(), "--html") != args.end();
+  // use -o to write the report to a file, replaced once it is complete
+  std::string output_file {};
+  it = std::find(args.begin(), args.end(), "-o");
+  if (it != args.end()) {
+    if (next(it) != args.end()) {
+      output_file = *next(it);
+    } else {
+      printf("%s: option -o requires an argument\n", bf::kProgramName.c_str());
+      usage();
+      return 1;
+    }
+  }
+  bf::Output out(output_file);
+  if (!out.is_open()) {
+    return 1;
+  }
   std::map<std::string, uint32_t> raw;
-  std::vector<ComputerGroup> final;
-  loadTarget(target_file, &final);
-  loadCurrent(current_file, &raw, &final);
-  display(current_file, &raw, &final);
+  GroupTable final;
+  // targets are loaded through the cache, then given their bands
+  auto loadTargets = [&]() {
+    if (!loadTarget(target_file, &final, cache)) {
+      return false;
+    }
+    if (banded) {
+      final.set_bands(amber, green);
+    }
+    return true;
+  };
+  if (!catalog_file.empty()) {
+    if (!loadTargets()) {
+      return 1;
+    }
+    std::vector<std::string> names;
+    for (auto cg : final) {
+      names.push_back(cg.name());
+    }
+    return bf::writeCatalog(names, target_file, catalog_file) ? 0 : 1;
+  }
+  if (!batch_dir.empty()) {
+    std::vector<std::string> files = bf::listReports(batch_dir);
+    if (std::find(args.begin(), args.end(), "--bench") != args.end()) {
+      benchRead(files, depth);
+    } else {
+      if (!loadTargets()) {
+        return 1;
+      }
+      loadBatch(files, depth, &pool, final, &out, html, columns, view);
+    }
+    if (!out.commit()) {
+      return 1;
+    }
+    if (stats) {
+      printStats(&pool);
+    }
+    return 0;
+  }
+  if (!partial_file.empty() || !merge_files.empty()) {
+    bf::Partial partial(approximate);
+    if (!loadPartial(current_files, endpoint_files, merge_files, &pool,
+                     &partial, columns, budget)) {
+      return 1;
+    }
+    if (!partial_file.empty()) {
+      return partial.save(partial_file) ? 0 : 1;
+    }
+    if (!loadTargets()) {
+      return 1;
+    }
+    const bf::EndpointSet& endpoints = partial.endpoints();
+    std::string label = partial.date() + bf::kExt;
+    bf::JoinResult join;
+    if (endpoints.size() == 0) {
+      raw = partial.raw();
+      updateCurrent(&raw, &final, joined ? &join : nullptr);
+    } else {
+      loadDistinct(endpoints, &raw, &final, joined ? &join : nullptr);
+    }
+    const bf::EndpointSet* distinct =
+        endpoints.size() == 0 ? nullptr : &endpoints;
+    if (html) {
+      displayHtml(&out, label, &raw, &final, distinct, view);
+    } else {
+      display(&out, label, &raw, &final, distinct, view);
+    }
+    if (joined) {
+      printJoin(&out, join, &final);
+    }
+    if (endpoints.approximate()) {
+      printApproximate(&out, endpoints);
+    }
+    if (!out.commit()) {
+      return 1;
+    }
+    if (stats) {
+      printStats(&pool);
+    }
+    return 0;
+  }
+  if (!loadTargets()) {
+    return 1;
+  }
+  if (!endpoint_files.empty()) {
+    if (!current_files.empty()) {
+      printf("Error: Report counts and endpoint exports cannot be mixed\n");
+      return 1;
+    }
+    bf::EndpointSet endpoints(approximate);
+    endpoints.set_budget(budget);
+    if (!bf::loadEndpoints(endpoint_files, &pool, &endpoints)) {
+      return 1;
+    }
+    bf::JoinResult join;
+    loadDistinct(endpoints, &raw, &final, joined ? &join : nullptr);
+    if (html) {
+      displayHtml(&out, endpoint_files.front(), &raw, &final, &endpoints,
+                  view);
+    } else {
+      display(&out, endpoint_files.front(), &raw, &final, &endpoints, view);
+    }
+    if (joined) {
+      printJoin(&out, join, &final);
+    }
+    if (endpoints.approximate()) {
+      printApproximate(&out, endpoints);
+    }
+    if (!expression.empty()) {
+      uint64_t count {0};
+      if (!endpoints.count(expression, &count)) {
+        out.flush();
+        printf("Error: Unknown computer group, unterminated quote or "
+               "unsupported operator in %s\n", expression.c_str());
+        return 1;
+      }
+      out.print("\n%s: %llu\n", expression.c_str(),
+                static_cast<unsigned long long>(count));  // NOLINT
+    }
+    if (!out.commit()) {
+      return 1;
+    }
+    if (stats) {
+      printStats(&pool);
+    }
+    return 0;
+  }
+  if (current_files.empty()) {
+    printf("%s: one of -c, -e, -b or --merge is required\n",
+           bf::kProgramName.c_str());
+    usage();
+    return 1;
+  }
+  std::vector<std::map<std::string, uint32_t>> per_source;
+  loadSources(current_files, &pool, &raw, &per_source, columns,
+              final.size(), cache);
+  bf::JoinResult join;
+  updateCurrent(&raw, &final, joined ? &join : nullptr);
+  if (html) {
+    displayHtml(&out, current_files.front(), &raw, &final, nullptr, view);
+  } else {
+    display(&out, current_files.front(), &raw, &final, nullptr, view);
+  }
+  if (sources) {
+    displaySources(&out, current_files, per_source, raw, html);
+  }
+  if (joined) {
+    printJoin(&out, join, &final);
+  }
+  if (!out.commit()) {
+    return 1;
+  }
+  if (stats) {
+    printStats(&pool);
+  }
+  return 0;
 }
 
 /**
- *  @details Load computer groups and target deployment counts
+ *  @details Load computer groups and target deployment counts from a mapped
+ *           copy of the file in a single pass
  */
-void loadTarget(std::string filename, std::vector<ComputerGroup>* final) {
-  std::ifstream fs(filename);
-  if (fs.is_open()) {
-    std::string line {};
-    while (std::getline(fs, line)) {
-      std::string group {};
-      uint16_t target {0};
-      std::size_t delim = line.find(bf::kDelim, 0);
-      // read computer group and target
-      group = line.substr(0, delim);
-      target = std::stoi(line.substr(delim + 1, line.length()));
-      // create new computer group
-      ComputerGroup cg = ComputerGroup(group);
-      cg.set_target(target);
-      final->push_back(cg);
-    }
-    fs.close();
+bool loadTarget(std::string filename, GroupTable* final) {
+  bf::MappedFile file(filename);
+  if (!file.is_open()) {
+    printf("Error: Could not open file %s\n", filename.c_str());
+    return false;
+  }
+  return bf::parseTargets(file.data(), file.size(), filename, final);
+}
+
+/**
+ *  @details Tables are cached by file identity, so an unchanged target file is
+ *           neither read nor interned again. The caller gets its own copy,
+ *           which shares the cached names; TOTAL is reserved up front so the
+ *           row added for display does not copy them.
+ */
+bool loadTarget(std::string filename, GroupTable* final, WarmCache* cache) {
+  std::string key;
+  if (cache == nullptr || !bf::fileKey(filename, &key)) {
+    return loadTarget(filename, final);
+  }
+  std::shared_ptr<const GroupTable> table = cache->targets.find(key);
+  if (table == nullptr) {
+    GroupTable loaded;
+    if (!loadTarget(filename, &loaded)) {
+      return false;
+    }
+    loaded.reserve("TOTAL");
+    cache->targets.insert(key, std::move(loaded));
+    table = cache->targets.find(key);
+  }
+  *final = *table;
+  return true;
+}
+
+namespace {
+
+/**
+ *  @brief Extract one group and count from a row, by the selected columns
+ *  @details Header rows update the layout; other rows are ignored until
+ *           every named column has been located
+ *  @param line start of the line
+ *  @param length length of the line, excluding any newline
+ *  @param layout positions of the group and count columns
+ *  @param counts receives the count of the computer group on the line
+ */
+template <typename Schema>
+void parseRow(const char* line, std::size_t length, bf::ColumnLayout* layout,
+              bf::CatalogCounts* counts) {
+  if (!bf::isRecord<Schema>(line, length)) {
+    return;
+  }
+  const std::size_t columns[] {layout->group(), layout->count()};
+  bf::Cell cells[2];
+  if (layout->ready() &&
+      bf::selectCells<Schema>(line, length, columns, 2, cells)) {
+    uint32_t number {0};
+    if (bf::parseNumber(cells[1].data, cells[1].length, &number)) {
+      counts->add(cells[0].data, cells[0].length, number);
+    }
+    return;
+  }
+  std::vector<bf::Cell> header;
+  bf::splitCells<typename Schema::Header>(line, length, &header);
+  if (!header.empty()) {
+    layout->header(header);
+  }
+}
+
+/**
+ *  @brief Parse the rest of a streamed report with one schema
+ *  @param fs report being read
+ *  @param line first row of the report, then each following line
+ *  @param columns columns to read, if any
+ *  @param filename name of the report, for warnings
+ *  @param raw collection of computer groups with raw deployment counts
+ */
+template <typename Schema>
+void parseLines(bf::Input* fs, std::string* line,
+                const bf::ReportColumns& columns, const std::string& filename,
+                std::map<std::string, uint32_t>* raw) {
+  bf::CatalogCounts counts(raw);
+  bf::ColumnLayout layout(columns, filename);
+  if (layout.selected()) {
+    do {
+      parseRow<Schema>(line->data(), line->length(), &layout, &counts);
+    } while (fs->getline(line));
   } else {
-    printf("Error: Could not open file %s", filename.c_str());
+    do {
+      parseLine<Schema>(line->data(), line->length(), &counts);
+    } while (fs->getline(line));
   }
+  counts.flush();
 }
 
 /**
- *  @details Load current deployment counts
+ *  @brief Parse every line of a report held in memory with one schema
+ *  @param data report contents
+ *  @param length length of data
+ *  @param columns columns to read, if any
+ *  @param filename name of the report, for warnings
+ *  @param raw collection of computer groups with raw deployment counts
+ */
+template <typename Schema>
+void parseLines(const char* data, std::size_t length,
+                const bf::ReportColumns& columns, const std::string& filename,
+                std::map<std::string, uint32_t>* raw) {
+  bf::CatalogCounts counts(raw);
+  bf::ColumnLayout layout(columns, filename);
+  bool selected = layout.selected();
+  std::size_t start {0};
+  while (start < length) {
+    const char* nl = static_cast<const char*>(
+        memchr(data + start, '\n', length - start));
+    std::size_t end = nl != nullptr ? nl - data : length;
+    if (selected) {
+      parseRow<Schema>(data + start, end - start, &layout, &counts);
+    } else {
+      parseLine<Schema>(data + start, end - start, &counts);
+    }
+    start = end + 1;
+  }
+  counts.flush();
+}
+
+}  // namespace
+
+/**
+ *  @details Load current deployment counts; the case of the table tags is
+ *           settled by the first row, so the rest of the report is parsed
+ *           by a matcher specialized for it
  */
 void loadCurrent(std::string filename, std::map<std::string, uint32_t>* raw,
-                 std::vector<ComputerGroup>* final) {
-  std::ifstream fs(filename);
+                 GroupTable* final, const bf::ReportColumns& columns) {
+  bf::ReportFormat format = bf::reportFormat(filename);
+  if (format != bf::ReportFormat::kHtml) {
+    if (format == bf::ReportFormat::kQuery) {
+      bf::loadQuery(filename, raw);
+    } else {
+      bf::loadCsv(filename, columns, raw);
+    }
+    updateCurrent(raw, final);
+    return;
+  }
+  bf::Input fs(filename);
   if (fs.is_open()) {
     std::string line {};
-    while (std::getline(fs, line)) {
-      if (line.compare(0, bf::kRecord.length(), bf::kRecord) == 0) {
-        // read records
-        std::size_t start = line.find(bf::kStart, 0), end {0};
-        while (start != std::string::npos) {
-          std::string group {};
-          uint32_t count {0};
-          // read computer group
-          end = line.find(bf::kEnd, start);
-          if (end != std::string::npos) {
-            start += bf::kStart.length();
-            group = line.substr(start, end - start);
-          }
-          // read computer count
-          start = line.find(bf::kStart, start + bf::kStart.length());
-          end = line.find(bf::kEnd, start);
-          if (end != std::string::npos) {
-            start += bf::kStart.length();
-            count = std::stoi(line.substr(start, end - start));
-          }
-          // populate collection
-          raw->emplace(group, count);
-          // read next computer group
-          start = line.find(bf::kStart, start + bf::kStart.length());
-        }
+    while (fs.getline(&line)) {
+      if (bf::isRecord<bf::UpperHtmlSchema>(line.data(), line.length())) {
+        parseLines<bf::UpperHtmlSchema>(&fs, &line, columns, filename, raw);
+      } else if (bf::isRecord<bf::HtmlSchema>(line.data(), line.length())) {
+        parseLines<bf::HtmlSchema>(&fs, &line, columns, filename, raw);
       }
     }
-    fs.close();
-    // update computer group collection
-    std::map<std::string, uint32_t>::iterator it;
-    for (auto &cg : *final) {
-      it = raw->find(cg.name());
-      if (it != raw->end()) {
-        cg.set_current(it->second);
-        // add MBDA current deployment stats to OS
-        if (cg.name() == "OS") {
-          it = raw->find("MBDA");
-          cg.set_current(cg.current() + it->second);
-        }
+    if (fs.failed()) {
+      bf::message("Error: File %s is truncated or corrupt\n", filename.c_str());
+    }
+    updateCurrent(raw, final);
+  } else {
+    bf::message("Error: Could not open file %s\n", filename.c_str());
+  }
+}
+
+/**
+ *  @details Extract computer group and count pairs from a table row; cells
+ *           are located and converted in place, and groups in the compiled
+ *           catalogue are counted without allocating their names at all
+ */
+template <typename Schema>
+void parseLine(const char* line, std::size_t length,
+               bf::CatalogCounts* counts) {
+  const std::size_t start_length {sizeof(Schema::kStart) - 1};
+  if (bf::isRecord<Schema>(line, length)) {
+    // read records
+    std::size_t start = bf::findTag(line, length, 0, Schema::kStart), end {0};
+    while (start != std::string::npos) {
+      const char* group {line};
+      std::size_t group_length {0};
+      uint32_t number {0};
+      // read computer group
+      end = bf::findTag(line, length, start, Schema::kEnd);
+      if (end != std::string::npos) {
+        start += start_length;
+        group = line + start;
+        group_length = end - start;
+      }
+      // read computer count
+      start = bf::findTag(line, length, start + start_length, Schema::kStart);
+      end = bf::findTag(line, length, start, Schema::kEnd);
+      if (end != std::string::npos) {
+        start += start_length;
+        bf::parseNumber(line + start, end - start, &number);
+      }
+      // populate collection
+      counts->add(group, group_length, number);
+      // read next computer group
+      if (start == std::string::npos) {
+        break;
       }
+      start = bf::findTag(line, length, start + start_length, Schema::kStart);
     }
+  }
+}
+
+template void parseLine<bf::HtmlSchema>(const char* line, std::size_t length,
+                                        bf::CatalogCounts* counts);
+template void parseLine<bf::UpperHtmlSchema>(const char* line,
+                                             std::size_t length,
+                                             bf::CatalogCounts* counts);
+
+/**
+ *  @details Split an in-memory report into lines without copying them. A
+ *           compressed report is inflated into the calling thread's arena,
+ *           which is reset first, so the buffer is reused from one report to
+ *           the next instead of being reallocated for each
+ */
+bool parseBuffer(const std::string& buffer, const std::string& filename,
+                 std::map<std::string, uint32_t>* raw,
+                 bf::ReportFormat format, const bf::ReportColumns& columns) {
+  const char* data = buffer.data();
+  std::size_t length = buffer.length();
+  const unsigned char* magic = reinterpret_cast<const unsigned char*>(data);
+  bf::Arena& arena = bf::Arena::local();
+  arena.reset();
+  bf::ArenaString plain {bf::ArenaAllocator<char>(&arena)};
+  if (bf::detect(magic, length) != bf::Compression::kNone) {
+    if (!bf::decompress(buffer, &plain)) {
+      return false;
+    }
+    data = plain.data();
+    length = plain.length();
+  }
+  if (format == bf::ReportFormat::kQuery) {
+    return bf::parseQuery(data, length, raw);
+  }
+  if (format == bf::ReportFormat::kCsv) {
+    return bf::parseCsv(data, length, columns, raw);
+  }
+  if (bf::isUpperCase(data, length)) {
+    parseLines<bf::UpperHtmlSchema>(data, length, columns, filename, raw);
   } else {
-    printf("Error: Could not open file %s", filename.c_str());
+    parseLines<bf::HtmlSchema>(data, length, columns, filename, raw);
   }
+  return true;
 }
 
 /**
- *  @details Display computer group, current, target and percentage
+ *  @details Copy raw counts into the matching computer groups, found by a
+ *           hash join on interned names; the join is handed back to callers
+ *           that print it so a report is joined only once
  */
-void display(std::string filename, std::map<std::string, uint32_t>* raw,
-             std::vector<ComputerGroup>* final) {
-  // extract date from filename
-  size_t begin = filename.length() - bf::kExt.length() - bf::kDate.length();
-  std::string date = filename.substr(begin, bf::kDate.length());
-  // store raw results
-  std::string raw_display[2] {"||  Date  || ", "| " + date + " | "};
-  // compute raw totals
-  uint32_t raw_total {0};
-  for (auto cg : *raw) {
-    raw_total += cg.second;
-    if (cg.first != "CBS" && cg.first != "HCHB") {
-      raw_display[0] += cg.first + " || ";
-      raw_display[1] += bf::format(cg.second) + " | ";
+void updateCurrent(std::map<std::string, uint32_t>* raw, GroupTable* final,
+                   bf::JoinResult* join) {
+  bf::JoinResult local;
+  if (join == nullptr) {
+    join = &local;
+  }
+  bf::join(*raw, *final, join);
+  for (const auto& match : join->matched) {
+    ComputerGroup cg = (*final)[match.row];
+    cg.set_current(match.count);
+    // add MBDA current deployment stats to OS
+    if (cg.name() == "OS") {
+      std::map<std::string, uint32_t>::iterator it = raw->find("MBDA");
+      if (it != raw->end()) {
+        cg.set_current(cg.current() + it->second);
+      }
     }
   }
-  raw_display[0] += "TOTAL ||";
-  raw_display[1] += bf::format(raw_total) + " |";
-  printf("%s\n%s\n\n", raw_display[0].c_str(), raw_display[1].c_str());
-  // compute final totals
-  uint32_t current_total {0}, target_total {0};
-  for (auto cg : *final) {
-    current_total += cg.current();
-    target_total += cg.target();
+}
+
+/**
+ *  @details Report-only groups are listed by name; counts are the report's
+ *           own, before any adjustment such as adding MBDA to OS
+ */
+void printJoin(bf::Output* out, const bf::JoinResult& join,
+               GroupTable* final) {
+  out->print("\nMatched: %zu groups, %s computers\n", join.matched.size(),
+         bf::format(static_cast<uint32_t>(join.matched_computers)).c_str());
+  out->print("Target only: %zu groups\n", join.target_only.size());
+  for (auto row : join.target_only) {
+    ComputerGroup cg = (*final)[row];
+    out->print("  %s (target %s)\n", cg.name().c_str(),
+           bf::format(cg.target()).c_str());
+  }
+  out->print("Report only: %zu groups, %s computers\n", join.report_only.size(),
+         bf::format(static_cast<uint32_t>(join.report_only_computers))
+             .c_str());
+  for (const auto& group : join.report_only) {
+    out->print("  %s (%s)\n", group.first.c_str(),
+           bf::format(group.second).c_str());
+  }
+}
+
+/**
+ *  @details Two standard errors cover the true count 95% of the time
+ */
+void printApproximate(bf::Output* out, const bf::EndpointSet& endpoints) {
+  out->print("\nCurrent counts are HyperLogLog estimates: +/-%.1f%% standard "
+         "error, +/-%.1f%% at 95%% confidence\n",
+         endpoints.error() * 100, endpoints.error() * 196);
+}
+
+/**
+ *  @details Each file is parsed by a pool task into that file's own map,
+ *           whose counts are then added to the shared totals; the counting
+ *           strategy is picked from the number of workers and the expected
+ *           number of groups
+ */
+void loadSources(const std::vector<std::string>& files, bf::ThreadPool* pool,
+                 std::map<std::string, uint32_t>* raw,
+                 std::vector<std::map<std::string, uint32_t>>* per_source,
+                 const bf::ReportColumns& columns, std::size_t groups,
+                 WarmCache* cache) {
+  per_source->assign(files.size(), std::map<std::string, uint32_t>());
+  // reports already in the cache are copied instead of parsed
+  std::vector<std::string> keys(files.size());
+  std::vector<std::size_t> missing;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    if (cache != nullptr && bf::fileKey(files[i], &keys[i])) {
+      keys[i] += '\0' + columns.group + '\0' + columns.count;
+      auto counts = cache->reports.find(keys[i]);
+      if (counts != nullptr) {
+        (*per_source)[i] = *counts;
+        continue;
+      }
+    }
+    missing.push_back(i);
+  }
+  bf::GroupCounters totals(pool->size(), groups);
+  std::vector<std::string> messages(files.size());
+  pool->run(missing.size(), [&](std::size_t task, std::size_t worker) {
+    std::size_t index = missing[task];
+    bf::DeferMessages defer(&messages[index]);
+    GroupTable none;
+    loadCurrent(files[index], &(*per_source)[index], &none, columns);
+    for (const auto& group : (*per_source)[index]) {
+      totals.add(worker, group.first, group.second);
+    }
+  });
+  for (const auto& text : messages) {
+    printf("%s", text.c_str());
+  }
+  std::map<std::string, uint64_t> sums;
+  totals.collect(&sums);
+  for (const auto& group : sums) {
+    raw->emplace_hint(raw->end(), group.first, 0)->second =
+        static_cast<uint32_t>(group.second);
+  }
+  // cached reports are merged in directly; both maps are sorted, so this is
+  // a single pass instead of a lookup per group
+  std::size_t next {0};
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    if (next < missing.size() && missing[next] == i) {
+      if (!keys[i].empty()) {
+        cache->reports.insert(keys[i], (*per_source)[i]);
+      }
+      ++next;
+      continue;
+    }
+    auto pos = raw->begin();
+    for (const auto& group : (*per_source)[i]) {
+      while (pos != raw->end() && pos->first < group.first) {
+        ++pos;
+      }
+      if (pos != raw->end() && pos->first == group.first) {
+        pos->second += group.second;
+      } else {
+        raw->emplace_hint(pos, group.first, group.second);
+      }
+    }
+  }
+}
+
+/**
+ *  @details Inputs are folded into the partial in the order report, endpoint
+ *           exports, saved partials; any of them may be absent. Summed report
+ *           counts say nothing about which computers they hold, so they
+ *           cannot be combined with endpoint memberships and a partial that
+ *           ends up with both is rejected
+ */
+bool loadPartial(const std::vector<std::string>& current_files,
+                 const std::vector<std::string>& endpoint_files,
+                 const std::vector<std::string>& merge_files,
+                 bf::ThreadPool* pool, bf::Partial* partial,
+                 const bf::ReportColumns& columns, std::size_t budget) {
+  if (!current_files.empty()) {
+    std::map<std::string, uint32_t> raw;
+    std::vector<std::map<std::string, uint32_t>> per_source;
+    loadSources(current_files, pool, &raw, &per_source, columns);
+    partial->add(bf::date(current_files.front()), raw);
+  }
+  if (!endpoint_files.empty()) {
+    bf::EndpointSet endpoints(partial->endpoints().approximate());
+    endpoints.set_budget(budget);
+    if (!bf::loadEndpoints(endpoint_files, pool, &endpoints)) {
+      return false;
+    }
+    partial->add(bf::date(endpoint_files.front()), endpoints);
+  }
+  for (const auto& file : merge_files) {
+    if (!partial->load(file)) {
+      return false;
+    }
+  }
+  if (!partial->raw().empty() && partial->endpoints().size() != 0) {
+    printf("Error: Report counts and endpoint exports cannot be mixed\n");
+    return false;
+  }
+  return true;
+}
+
+/**
+ *  @details Per-group counts come straight from the bitmaps; OS then counts
+ *           the union of OS and MBDA so computers in both are counted once
+ */
+void loadDistinct(const bf::EndpointSet& endpoints,
+                  std::map<std::string, uint32_t>* raw, GroupTable* final,
+                  bf::JoinResult* join) {
+  endpoints.counts(raw);
+  bf::JoinResult local;
+  if (join == nullptr) {
+    join = &local;
+  }
+  bf::join(*raw, *final, join);
+  for (const auto& match : join->matched) {
+    ComputerGroup cg = (*final)[match.row];
+    if (cg.name() == "OS") {
+      cg.set_current(static_cast<uint32_t>(
+          endpoints.distinct({"OS", "MBDA"})));
+    } else {
+      cg.set_current(match.count);
+    }
+  }
+}
+
+/**
+ *  @details Read all reports through the read engine and parse each one as a
+ *           pool task, holding at most depth parsed-but-unread buffers, then
+ *           display them in file name order so output does not depend on
+ *           completion order
+ */
+void loadBatch(const std::vector<std::string>& files, std::size_t depth,
+               bf::ThreadPool* pool, const GroupTable& targets,
+               bf::Output* out, bool html, const bf::ReportColumns& columns,
+               const bf::View& view) {
+  std::vector<std::map<std::string, uint32_t>> raws(files.size());
+  std::vector<std::string> buffers(files.size()), messages(files.size());
+  std::vector<char> read(files.size(), 0), loaded(files.size(), 0);
+  bf::ReadEngine engine(depth);
+  engine.run(files, [&](std::size_t index, std::string* buffer, bool ok) {
+    if (!ok) {
+      return;
+    }
+    pool->wait(depth);
+    read[index] = 1;
+    buffers[index] = std::move(*buffer);
+    pool->submit([&, index](std::size_t) {
+      bf::DeferMessages defer(&messages[index]);
+      loaded[index] = parseBuffer(buffers[index], files[index], &raws[index],
+                                  bf::reportFormat(files[index]), columns);
+      std::string().swap(buffers[index]);
+    });
+  });
+  pool->wait();
+  // reads and parses finish in any order, so errors are reported by file
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    printf("%s", messages[i].c_str());
+    if (!read[i]) {
+      printf("Error: Could not open file %s\n", files[i].c_str());
+    } else if (!loaded[i]) {
+      printf("Error: File %s is truncated or corrupt\n", files[i].c_str());
+    }
+  }
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    if (loaded[i]) {
+      GroupTable final = targets;
+      updateCurrent(&raws[i], &final);
+      if (html) {
+        displayHtml(out, files[i], &raws[i], &final, nullptr, view);
+      } else {
+        display(out, files[i], &raws[i], &final, nullptr, view);
+      }
+      out->print("\n");
+    }
+  }
+}
+
+/**
+ *  @details Alternate between the stream path and the read engine so both
+ *           see a similarly warm page cache, and report the best of each
+ */
+void benchRead(const std::vector<std::string>& files, std::size_t depth) {
+  const int rounds {3};
+  uint64_t bytes {0};
+  for (const auto& file : files) {
+    struct stat st;
+    if (stat(file.c_str(), &st) == 0) {
+      bytes += static_cast<uint64_t>(st.st_size);
+    }
+  }
+  bf::ReadEngine engine(depth);
+  double stream_best {0}, engine_best {0};
+  for (int round = 0; round < rounds; ++round) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (const auto& file : files) {
+      std::map<std::string, uint32_t> raw;
+      GroupTable none;
+      loadCurrent(file, &raw, &none);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    engine.run(files, [&files](std::size_t index, std::string* buffer,
+                               bool ok) {
+      std::map<std::string, uint32_t> raw;
+      if (ok) {
+        parseBuffer(*buffer, files[index], &raw,
+                    bf::reportFormat(files[index]));
+      }
+    });
+    auto t2 = std::chrono::steady_clock::now();
+    double stream = std::chrono::duration<double>(t1 - t0).count();
+    double read = std::chrono::duration<double>(t2 - t1).count();
+    if (round == 0 || stream < stream_best) {
+      stream_best = stream;
+    }
+    if (round == 0 || read < engine_best) {
+      engine_best = read;
+    }
+  }
+  double mb = bytes / 1e6;
+  std::string label = std::string(engine.backend()) + " x" +
+                      std::to_string(depth);
+  printf("%s: %zu files, %llu bytes, best of %d rounds\n",
+         bf::kProgramName.c_str(), files.size(),
+         static_cast<unsigned long long>(bytes), rounds);  // NOLINT
+  printf("%-12s: %8.3f s %10.1f MB/s\n", "stream", stream_best,
+         stream_best > 0 ? mb / stream_best : 0);
+  printf("%-12s: %8.3f s %10.1f MB/s\n", label.c_str(), engine_best,
+         engine_best > 0 ? mb / engine_best : 0);
+}
+
+/**
+ *  @details One line per worker followed by the totals; idle time counts
+ *           every wait for work since the pool started
+ */
+void printStats(bf::ThreadPool* pool) {
+  std::vector<bf::WorkerStats> workers = pool->stats();
+  bf::WorkerStats total;
+  printf("\n%s: %zu workers%s\n", bf::kProgramName.c_str(), workers.size(),
+         pool->pinned() ? ", pinned to CPUs" : "");
+  printf("%8s %10s %10s %10s %12s %12s\n", "worker", "tasks", "steals",
+         "max queue", "busy ms", "idle ms");
+  for (std::size_t i = 0; i < workers.size(); ++i) {
+    const bf::WorkerStats& w = workers[i];
+    printf("%8zu %10llu %10llu %10zu %12.1f %12.1f\n", i,
+           static_cast<unsigned long long>(w.tasks),  // NOLINT
+           static_cast<unsigned long long>(w.steals),  // NOLINT
+           w.max_depth, w.busy * 1e3, w.idle * 1e3);
+    total.tasks += w.tasks;
+    total.steals += w.steals;
+    total.max_depth = std::max(total.max_depth, w.max_depth);
+    total.busy += w.busy;
+    total.idle += w.idle;
+  }
+  printf("%8s %10llu %10llu %10zu %12.1f %12.1f\n", "total",
+         static_cast<unsigned long long>(total.tasks),  // NOLINT
+         static_cast<unsigned long long>(total.steals),  // NOLINT
+         total.max_depth, total.busy * 1e3, total.idle * 1e3);
+}
+
+/**
+ *  @details Every thread adds to pseudo-random groups out of a fixed set, so
+ *           the only difference between runs is how counts are combined;
+ *           collecting the totals is included in the timings
+ */
+void benchCounters(bf::ThreadPool* pool) {
+  const std::size_t cardinalities[] {16, 256, 4096, 65536, 262144,
+                                       1048576};
+  const std::size_t adds {1 << 21};
+  std::size_t threads = pool->size();
+  printf("%s: %zu threads, %zu adds per thread, Mops/s\n",
+         bf::kProgramName.c_str(), threads, adds);
+  printf("%10s %10s %10s  %s\n", "groups", "shared", "local", "chosen");
+  for (std::size_t groups : cardinalities) {
+    std::vector<std::string> names(groups);
+    for (std::size_t i = 0; i < groups; ++i) {
+      names[i] = "Group " + std::to_string(i);
+    }
+    double rates[2];
+    const bf::CounterStrategy strategies[] {bf::CounterStrategy::kShared,
+                                            bf::CounterStrategy::kLocal};
+    for (int s = 0; s < 2; ++s) {
+      auto t0 = std::chrono::steady_clock::now();
+      bf::GroupCounters counters(threads, groups, strategies[s]);
+      pool->run(threads, [&](std::size_t index, std::size_t worker) {
+        uint64_t x = 0x9e3779b97f4a7c15ULL * (index + 1);
+        for (std::size_t n = 0; n < adds; ++n) {
+          x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+          counters.add(worker, names[(x >> 33) % groups], 1);
+        }
+      });
+      std::map<std::string, uint64_t> totals;
+      counters.collect(&totals);
+      auto t1 = std::chrono::steady_clock::now();
+      double seconds = std::chrono::duration<double>(t1 - t0).count();
+      rates[s] = seconds > 0 ? threads * adds / seconds / 1e6 : 0;
+    }
+    printf("%10zu %10.1f %10.1f  %s\n", groups, rates[0], rates[1],
+           bf::chooseStrategy(threads, groups) ==
+           bf::CounterStrategy::kShared ? "shared" : "local");
+  }
+}
+
+namespace {
+
+/**
+ *  @brief Number of computers in all raw computer groups
+ *  @param raw collection of raw computer group deployment counts
+ *  @param endpoints per-endpoint membership, or nullptr if not available
+ *  @retval uint32_t distinct computers if endpoints are available, otherwise
+ *          the sum of the raw counts
+ */
+uint32_t rawTotal(const std::map<std::string, uint32_t>& raw,
+                  const bf::EndpointSet* endpoints) {
+  if (endpoints != nullptr) {
+    return static_cast<uint32_t>(endpoints->distinct());
   }
-  ComputerGroup total = ComputerGroup("TOTAL");
+  uint32_t total {0};
+  for (const auto& cg : raw) {
+    total += cg.second;
+  }
+  return total;
+}
+
+/**
+ *  @brief Append the TOTAL row to the finalized computer groups
+ *  @param final collection of computer groups with finalized counts
+ *  @param endpoints per-endpoint membership, or nullptr if not available
+ */
+void addTotal(GroupTable* final, const bf::EndpointSet* endpoints) {
+  uint32_t current_total = final->total_current();
+  uint32_t target_total = final->total_target();
+  if (endpoints != nullptr) {
+    // count each computer once, including MBDA computers counted under OS
+    std::vector<std::string> names {"MBDA"};
+    for (auto cg : *final) {
+      names.push_back(cg.name());
+    }
+    current_total = static_cast<uint32_t>(endpoints->distinct(names));
+  }
+  ComputerGroup total = final->add("TOTAL");
   total.set_current(current_total);
   total.set_target(target_total);
-  final->push_back(total);
-  // populate rows
-  std::string header = "|| Nodes    || ";
-  std::string current = "| *Current* | ";
-  std::string target = "| *Target*  | ";
-  std::string percent = "| *%Comp*   | ";
-  // display results
-  for (auto cg : *final) {
-    header += cg.formatted_name() + " || ";
-    current += cg.formatted_current() + " | ";
-    target += cg.formatted_target() + " | ";
-    percent += cg.formatted_percent() + " | ";
+}
+
+/**
+ *  @brief Print raw counts as Confluence tables, writing each cell directly
+ *  @param date date of the report
+ *  @param cells name and count of each column, ending with TOTAL
+ *  @param page columns per table, or zero for a single table
+ *  @param transposed print one column per line instead
+ */
+void printRaw(bf::Output* out, const std::string& date,
+              const std::vector<std::pair<const std::string*, uint32_t>>& cells,
+              std::size_t page, bool transposed) {
+  if (transposed) {
+    out->print("||  Date  || %s ||\n", date.c_str());
+    for (const auto& cell : cells) {
+      out->print("| %s | %s |\n", cell.first->c_str(),
+             bf::format(cell.second).c_str());
+    }
+    out->print("\n");
+    return;
+  }
+  std::size_t step = page > 0 ? page : cells.size();
+  for (std::size_t start = 0; start < cells.size(); start += step) {
+    std::size_t end = std::min(start + step, cells.size());
+    out->print("||  Date  ||");
+    for (std::size_t i = start; i < end; ++i) {
+      out->print(" %s ||", cells[i].first->c_str());
+    }
+    out->print("\n| %s |", date.c_str());
+    for (std::size_t i = start; i < end; ++i) {
+      out->print(" %s |", bf::format(cells[i].second).c_str());
+    }
+    out->print("\n\n");
+  }
+}
+
+/**
+ *  @brief Print computer groups as Confluence tables, writing each cell
+ *         directly
+ *  @details Column widths are computed one table at a time, so memory use
+ *           does not grow with the number of computer groups; nothing is
+ *           printed when the view shows none of the group rows
+ *  @param final collection of computer groups with finalized counts
+ *  @param rows rows of final to print, in order
+ *  @param view rows, table width and layout to print
+ */
+void printGroups(bf::Output* out, GroupTable* final,
+                 const std::vector<std::size_t>& rows, const bf::View& view) {
+  struct Line {
+    bf::Row row;
+    const char* label;
+    std::string (ComputerGroup::*cell)(uint8_t) const;
+  };
+  const Line lines[] {
+    {bf::kCurrentRow, "| *Current* | ", &ComputerGroup::formatted_current},
+    {bf::kTargetRow, "| *Target*  | ", &ComputerGroup::formatted_target},
+    {bf::kPercentRow, "| *%Comp*   | ", &ComputerGroup::formatted_percent}};
+  if ((view.rows() & bf::kGroupRows) == 0) {
+    return;
+  }
+  if (view.transposed()) {
+    out->print("|| Nodes ||%s%s%s\n",
+           view.shows(bf::kCurrentRow) ? " Current ||" : "",
+           view.shows(bf::kTargetRow) ? " Target ||" : "",
+           view.shows(bf::kPercentRow) ? " %Comp ||" : "");
+    for (std::size_t row : rows) {
+      ComputerGroup cg = (*final)[row];
+      out->print("| %s%s |", cg.name().c_str(), cg.name() == "OS" ? "*" : "");
+      if (view.shows(bf::kCurrentRow)) {
+        out->print(" %s |", bf::format(cg.current()).c_str());
+      }
+      if (view.shows(bf::kTargetRow)) {
+        out->print(" %s |", bf::format(cg.target()).c_str());
+      }
+      if (view.shows(bf::kPercentRow)) {
+        out->print(" %s |", cg.percent_text().c_str());
+      }
+      out->print("\n");
+    }
+    return;
+  }
+  std::size_t step = view.page() > 0 ? view.page() : rows.size();
+  std::vector<uint8_t> widths;
+  for (std::size_t start = 0; start < rows.size(); start += step) {
+    std::size_t end = std::min(start + step, rows.size());
+    widths.clear();
+    for (std::size_t i = start; i < end; ++i) {
+      widths.push_back((*final)[rows[i]].widest(view.rows()));
+    }
+    if (start > 0) {
+      out->print("\n");
+    }
+    out->print("|| Nodes    || ");
+    for (std::size_t i = start; i < end; ++i) {
+      out->print("%s || ",
+             (*final)[rows[i]].formatted_name(widths[i - start]).c_str());
+    }
+    out->print("\n");
+    for (const auto& line : lines) {
+      if (!view.shows(line.row)) {
+        continue;
+      }
+      out->print("%s", line.label);
+      for (std::size_t i = start; i < end; ++i) {
+        ComputerGroup cg = (*final)[rows[i]];
+        out->print("%s | ", (cg.*line.cell)(widths[i - start]).c_str());
+      }
+      out->print("\n");
+    }
+  }
+}
+
+}  // namespace
+
+/**
+ *  @details Display computer group, current, target and percentage. Only the
+ *           selected groups are visited, and only the cells of the selected
+ *           rows are formatted; tables are streamed cell by cell
+ */
+void display(bf::Output* out, std::string filename,
+             std::map<std::string, uint32_t>* raw, GroupTable* final,
+             const bf::EndpointSet* endpoints,
+             const bf::View& view) {
+  if (view.shows(bf::kRawRow)) {
+    const std::string total {"TOTAL"};
+    std::vector<std::pair<const std::string*, uint32_t>> cells;
+    for (const auto& cg : *raw) {
+      if (cg.first != "CBS" && cg.first != "HCHB" && view.matches(cg.first)) {
+        cells.emplace_back(&cg.first, cg.second);
+      }
+    }
+    cells.emplace_back(&total, rawTotal(*raw, endpoints));
+    printRaw(out, bf::date(filename), cells, view.page(),
+             view.transposed());
+  }
+  // compute final totals
+  addTotal(final, endpoints);
+  printGroups(out, final, view.select(final), view);
+}
+
+/**
+ *  @details Same content as display, as two HTML tables; when the group table
+ *           has deployment bands, each percentage cell is shaded by its band
+ */
+void displayHtml(bf::Output* out, std::string filename,
+                 std::map<std::string, uint32_t>* raw, GroupTable* final,
+                 const bf::EndpointSet* endpoints,
+                 const bf::View& view) {
+  const char* shades[] {"#f2dede", "#fcf8e3", "#dff0d8"};
+  if (view.shows(bf::kRawRow)) {
+    std::string date = bf::date(filename);
+    // raw results
+    std::string raw_display[2] {"<tr><th>Date</th>",
+                                "<tr><td>" + date + "</td>"};
+    uint32_t raw_total = rawTotal(*raw, endpoints);
+    for (auto cg : *raw) {
+      if (cg.first != "CBS" && cg.first != "HCHB" && view.matches(cg.first)) {
+        raw_display[0] += "<th>" + bf::escape(cg.first) + "</th>";
+        raw_display[1] += "<td>" + bf::format(cg.second) + "</td>";
+      }
+    }
+    raw_display[0] += "<th>TOTAL</th></tr>";
+    raw_display[1] += "<td>" + bf::format(raw_total) + "</td></tr>";
+    out->print("<table class=\"%s-raw\">\n%s\n%s\n</table>\n",
+           bf::kProgramName.c_str(), raw_display[0].c_str(),
+           raw_display[1].c_str());
+  }
+  // final results
+  addTotal(final, endpoints);
+  unsigned rows = view.rows();
+  if ((rows & bf::kGroupRows) == 0) {
+    return;
+  }
+  std::string header = "<tr><th>Nodes</th>";
+  std::string current = "<tr><th>Current</th>";
+  std::string target = "<tr><th>Target</th>";
+  std::string percent = "<tr><th>%Comp</th>";
+  for (std::size_t row : view.select(final)) {
+    ComputerGroup cg = (*final)[row];
+    header += "<th>" + bf::escape(cg.name()) +
+              (cg.name() == "OS" ? "*" : "") + "</th>";
+    if (rows & bf::kCurrentRow) {
+      current += "<td>" + bf::format(cg.current()) + "</td>";
+    }
+    if (rows & bf::kTargetRow) {
+      target += "<td>" + bf::format(cg.target()) + "</td>";
+    }
+    if (rows & bf::kPercentRow) {
+      if (final->banded()) {
+        percent += std::string("<td style=\"background-color:") +
+                   shades[static_cast<int>(cg.band())] + "\">";
+      } else {
+        percent += "<td>";
+      }
+      percent += std::to_string(cg.percent()) + "</td>";
+    }
+  }
+  out->print("<table class=\"%s\">\n%s</tr>\n", bf::kProgramName.c_str(),
+         header.c_str());
+  if (rows & bf::kCurrentRow) {
+    out->print("%s</tr>\n", current.c_str());
+  }
+  if (rows & bf::kTargetRow) {
+    out->print("%s</tr>\n", target.c_str());
+  }
+  if (rows & bf::kPercentRow) {
+    out->print("%s</tr>\n", percent.c_str());
+  }
+  out->print("</table>\n");
+}
+
+/**
+ *  @details One row per source, labelled with the file name less its
+ *           directory and extensions, then the summed row; columns and totals
+ *           follow the raw table, which leaves out CBS and HCHB but counts
+ *           them in the total
+ */
+void displaySources(bf::Output* out,
+                    const std::vector<std::string>& files,
+                    const std::vector<std::map<std::string, uint32_t>>& sources,
+                    const std::map<std::string, uint32_t>& raw, bool html) {
+  std::vector<std::string> labels;
+  for (const auto& file : files) {
+    std::string name = bf::uncompressedName(file);
+    name = name.substr(name.find_last_of('/') + 1);
+    labels.push_back(name.substr(0, name.find_last_of('.')));
+  }
+  labels.push_back("TOTAL");
+  std::vector<const std::map<std::string, uint32_t>*> rows;
+  for (const auto& source : sources) {
+    rows.push_back(&source);
+  }
+  rows.push_back(&raw);
+  std::string header = html ? "<tr><th>Source</th>" : "||  Source  || ";
+  for (const auto& group : raw) {
+    if (group.first != "CBS" && group.first != "HCHB") {
+      header += html ? "<th>" + bf::escape(group.first) + "</th>"
+                     : group.first + " || ";
+    }
+  }
+  header += html ? "<th>TOTAL</th></tr>" : "TOTAL ||";
+  if (html) {
+    out->print("<table class=\"%s-sources\">\n", bf::kProgramName.c_str());
+  } else {
+    out->print("\n");
+  }
+  out->print("%s\n", header.c_str());
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    std::string line = html ? "<tr><td>" + bf::escape(labels[i]) + "</td>"
+                            : "| " + labels[i] + " | ";
+    uint32_t total = rawTotal(*rows[i], nullptr);
+    for (const auto& group : raw) {
+      if (group.first == "CBS" || group.first == "HCHB") {
+        continue;
+      }
+      auto it = rows[i]->find(group.first);
+      uint32_t count = it != rows[i]->end() ? it->second : 0;
+      line += html ? "<td>" + bf::format(count) + "</td>"
+                   : bf::format(count) + " | ";
+    }
+    line += html ? "<td>" + bf::format(total) + "</td></tr>"
+                 : bf::format(total) + " |";
+    out->print("%s\n", line.c_str());
+  }
+  if (html) {
+    out->print("</table>\n");
   }
-  printf("%s\n%s\n%s\n%s\n", header.c_str(), current.c_str(), target.c_str(),
-         percent.c_str());
 }
 
 /**
@@ -312,9 +1606,94 @@ void display(std::string filename, std::map<std::string, uint32_t>* raw,
 void usage() {
   printf("%s, version %u.%u\n\n", bf::kProgramName.c_str(), bf::kMajorVersion,
          bf::kMinorVersion);
-  printf("usage: %s [-h] -t target -c current \n", bf::kProgramName.c_str());
+  printf("usage: %s [-h] -t target -c current [-c current ...] [--sources]\n",
+         bf::kProgramName.c_str());
+  printf("       %s [-h] -t target -e endpoints [--approx] [--count expr]\n",
+         bf::kProgramName.c_str());
+  printf("       %s [-h] -t target -b directory [-q depth] [--bench]\n",
+         bf::kProgramName.c_str());
+  printf("       %s [-h] [-c current] [-e endpoints] [--merge partial ...]\n"
+         "          [--approx] --emit-partial partial\n",
+         bf::kProgramName.c_str());
+  printf("       %s [-h] -t target --merge partial ...\n",
+         bf::kProgramName.c_str());
+  printf("       %s [-h] -t target --emit-catalog header\n",
+         bf::kProgramName.c_str());
+  printf("       %s --serve socket [--cache entries]\n",
+         bf::kProgramName.c_str());
+  printf("       %s --connect socket [options ...]\n",
+         bf::kProgramName.c_str());
+  printf("options: [--bands amber,green] [--html] [-j threads] [--affinity]"
+         "\n         [--stats]\n");
   printf("-h display usage\n");
-  printf("-t filename of the comma-separated computer group targets\n");
-  printf("-c filename of the current computer group deployment statistics\n\n");
+  printf("-t filename of the comma-separated computer group targets; blank\n");
+  printf("   lines and lines starting with %c are ignored\n", bf::kComment);
+  printf("-c filename of the current computer group deployment statistics;\n");
+  printf("   repeat to sum the counts of several servers\n");
+  printf("   (plain, gzip or zstd compressed), either a Web Reports HTML\n");
+  printf("   or CSV (.csv) export or a saved REST API /api/query XML\n");
+  printf("   response (.xml)\n");
+  printf("--group-column name or position (from 1) of the column holding\n");
+  printf("   computer groups in CSV or HTML reports (default the first CSV\n");
+  printf("   column; HTML cells are read in group, count pairs)\n");
+  printf("--count-column name or position of the column holding computer\n");
+  printf("   counts (default the second CSV column)\n");
+  printf("-e filename of a per-endpoint export to use instead of -c, so\n");
+  printf("   computers in several groups are counted once\n");
+  printf("   (may be repeated to combine several exports)\n");
+  printf("--approx with -e, estimate counts with HyperLogLog sketches using\n");
+  printf("   a few kilobytes per group instead of exact bitmaps\n");
+  printf("--count expression with -e, count computers in groups combined\n");
+  printf("   left to right with | (or), & (and) and - (not), e.g. OS-MBDA;\n");
+  printf("   quote names holding these, e.g. '\"Windows-Servers\"&OS';\n");
+  printf("   only | is supported with --approx\n");
+  printf("--max-memory size with -e, sort computers waiting to be added\n");
+  printf("   to groups in runs of at most this size (e.g. 512M) and spill\n");
+  printf("   them to $TMPDIR, merging the runs when each export is done\n");
+  printf("--emit-partial filename to save the counts from -c, -e and\n");
+  printf("   --merge inputs as a partial aggregate instead of displaying\n");
+  printf("--merge filenames of partial aggregates to combine and display;\n");
+  printf("   partials may be merged in any order or grouping, and\n");
+  printf("   --merge may be repeated\n");
+  printf("--emit-catalog filename of a header to generate with a perfect\n");
+  printf("   hash of the target groups, for \"make catalog TARGETS=file\"\n");
+  printf("-b directory of deployment statistics to process as a batch\n");
+  printf("-q number of batch file reads kept in flight (default %zu)\n",
+         bf::kReadDepth);
+  printf("--bench compare batch read throughput with the stream path\n");
+  printf("--bench-counters compare shared and per-thread group counting\n");
+  printf("-j number of worker threads for parallel work (default %zu)\n",
+         bf::defaultThreads());
+  printf("--affinity pin each worker thread to its own CPU\n");
+  printf("--stats report tasks, steals, queue depth and idle time of each\n");
+  printf("   worker thread\n");
+  printf("--bands amber,green color percentages by the lowest amber and\n");
+  printf("   green percentages (default %u,%u)\n", bf::kAmberPercent,
+         bf::kGreenPercent);
+  printf("--join with -c, -e or --merge, list the groups matched with\n");
+  printf("   targets and those found only in the targets or the report\n");
+  printf("--sources with several -c files, also show each file's counts\n");
+  printf("--groups only display groups matching one of these comma-\n");
+  printf("   separated wildcards or /regular expressions/ (TOTAL is always\n");
+  printf("   shown and counts every group)\n");
+  printf("--rows only display these comma-separated rows: raw, current,\n");
+  printf("   target, comp\n");
+  printf("--sort order groups by percent, current, target or gap (target\n");
+  printf("   less current), highest first\n");
+  printf("--top N only display the N highest groups in the --sort order\n");
+  printf("   (by percent if no order is given)\n");
+  printf("--bottom N only display the N lowest groups, lowest first\n");
+  printf("--page N split Confluence tables after every N groups (default\n");
+  printf("   %zu, 0 for a single table)\n", bf::kPageColumns);
+  printf("--transpose display Confluence tables with one group per line\n");
+  printf("--html display HTML tables instead of Confluence markup\n");
+  printf("--serve socket keep answering requests on a Unix-domain socket,\n");
+  printf("   caching parsed targets and reports until they change\n");
+  printf("--cache N with --serve, keep N targets and N reports (default\n");
+  printf("   %zu)\n", bf::kCacheEntries);
+  printf("--connect socket have a --serve daemon produce the report\n");
+  printf("-o filename to write the report to instead of the standard\n");
+  printf("   output; the file is only replaced once the report is\n");
+  printf("   complete\n\n");
 }
 
@@ -0,0 +1,315 @@
+/**
+ *  @file bitmap.cpp
+ *  @brief Compressed bitmap of 32-bit computer identifiers
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "bigfix/bitmap.h"
+
+const uint32_t bf::Bitmap::kArrayLimit;
+const std::size_t bf::Bitmap::kWords;
+
+void bf::Bitmap::Container::to_bitset() {
+  bits.assign(kWords, 0);
+  for (auto low : array) {
+    bits[low >> 6] |= uint64_t {1} << (low & 63);
+  }
+  std::vector<uint16_t>().swap(array);
+}
+
+void bf::Bitmap::Container::to_array() {
+  array.clear();
+  array.reserve(cardinality);
+  for (std::size_t w = 0; w < kWords; ++w) {
+    for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+      array.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(word)));
+    }
+  }
+  std::vector<uint64_t>().swap(bits);
+}
+
+/**
+ *  @details Computer IDs usually arrive in ascending order, so appending to
+ *           the end of an array container is checked first
+ */
+bool bf::Bitmap::Container::add(uint16_t low) {
+  if (dense()) {
+    uint64_t mask = uint64_t {1} << (low & 63);
+    if (bits[low >> 6] & mask) {
+      return false;
+    }
+    bits[low >> 6] |= mask;
+  } else if (array.empty() || array.back() < low) {
+    array.push_back(low);
+  } else {
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (*it == low) {
+      return false;
+    }
+    array.insert(it, low);
+  }
+  if (++cardinality > kArrayLimit && !dense()) {
+    to_bitset();
+  }
+  return true;
+}
+
+bool bf::Bitmap::Container::contains(uint16_t low) const {
+  if (dense()) {
+    return (bits[low >> 6] >> (low & 63)) & 1;
+  }
+  return std::binary_search(array.begin(), array.end(), low);
+}
+
+bool bf::Bitmap::add(uint32_t value) {
+  uint16_t key = static_cast<uint16_t>(value >> 16);
+  std::size_t i = keys_.size();
+  if (keys_.empty() || keys_.back() != key) {
+    auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+    i = it - keys_.begin();
+    if (it == keys_.end() || *it != key) {
+      keys_.insert(it, key);
+      containers_.insert(containers_.begin() + i, Container());
+    }
+  } else {
+    i = keys_.size() - 1;
+  }
+  return containers_[i].add(static_cast<uint16_t>(value));
+}
+
+bool bf::Bitmap::contains(uint32_t value) const {
+  uint16_t key = static_cast<uint16_t>(value >> 16);
+  auto it = std::lower_bound(keys_.begin(), keys_.end(), key);
+  if (it == keys_.end() || *it != key) {
+    return false;
+  }
+  return containers_[it - keys_.begin()].contains(static_cast<uint16_t>(value));
+}
+
+uint64_t bf::Bitmap::cardinality() const {
+  uint64_t total {0};
+  for (const auto& c : containers_) {
+    total += c.cardinality;
+  }
+  return total;
+}
+
+void bf::Bitmap::values(std::vector<uint32_t>* values) const {
+  values->clear();
+  values->reserve(static_cast<std::size_t>(cardinality()));
+  for (std::size_t i = 0; i < keys_.size(); ++i) {
+    uint32_t high = static_cast<uint32_t>(keys_[i]) << 16;
+    const Container& c = containers_[i];
+    if (!c.dense()) {
+      for (auto low : c.array) {
+        values->push_back(high | low);
+      }
+      continue;
+    }
+    for (std::size_t w = 0; w < kWords; ++w) {
+      for (uint64_t word = c.bits[w]; word != 0; word &= word - 1) {
+        values->push_back(high | static_cast<uint32_t>(
+            w * 64 + __builtin_ctzll(word)));
+      }
+    }
+  }
+}
+
+std::size_t bf::Bitmap::bytes() const {
+  std::size_t total = keys_.size() * sizeof(uint16_t);
+  for (const auto& c : containers_) {
+    total += sizeof(Container) + c.array.size() * sizeof(uint16_t) +
+             c.bits.size() * sizeof(uint64_t);
+  }
+  return total;
+}
+
+/**
+ *  @details Two arrays are merged as sorted sequences; an array against a
+ *           bitset probes the bitset; anything else works word by word on
+ *           bitsets. The result is converted to whichever representation
+ *           suits its cardinality.
+ */
+bf::Bitmap::Container bf::Bitmap::merge(const Container& a,
+                                        const Container& b, Op op) {
+  Container c;
+  if (!a.dense() && !b.dense()) {
+    auto out = std::back_inserter(c.array);
+    if (op == kOr) {
+      std::set_union(a.array.begin(), a.array.end(), b.array.begin(),
+                     b.array.end(), out);
+    } else if (op == kAnd) {
+      std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(),
+                            b.array.end(), out);
+    } else {
+      std::set_difference(a.array.begin(), a.array.end(), b.array.begin(),
+                          b.array.end(), out);
+    }
+    c.cardinality = static_cast<uint32_t>(c.array.size());
+    if (c.cardinality > kArrayLimit) {
+      c.to_bitset();
+    }
+    return c;
+  }
+  if (op != kOr && !a.dense()) {
+    // sparse left side: keep the values the bitset does (or does not) hold
+    for (auto low : a.array) {
+      if (b.contains(low) == (op == kAnd)) {
+        c.array.push_back(low);
+      }
+    }
+    c.cardinality = static_cast<uint32_t>(c.array.size());
+    return c;
+  }
+  if (op == kAnd && !b.dense()) {
+    for (auto low : b.array) {
+      if (a.contains(low)) {
+        c.array.push_back(low);
+      }
+    }
+    c.cardinality = static_cast<uint32_t>(c.array.size());
+    return c;
+  }
+  Container left = a, right = b;
+  if (!left.dense()) {
+    left.to_bitset();
+  }
+  if (!right.dense()) {
+    right.to_bitset();
+  }
+  c.bits.assign(kWords, 0);
+  uint32_t cardinality {0};
+  for (std::size_t w = 0; w < kWords; ++w) {
+    uint64_t word;
+    if (op == kOr) {
+      word = left.bits[w] | right.bits[w];
+    } else if (op == kAnd) {
+      word = left.bits[w] & right.bits[w];
+    } else {
+      word = left.bits[w] & ~right.bits[w];
+    }
+    c.bits[w] = word;
+    cardinality += __builtin_popcountll(word);
+  }
+  c.cardinality = cardinality;
+  if (cardinality <= kArrayLimit) {
+    c.to_array();
+  }
+  return c;
+}
+
+void bf::Bitmap::combine(const Bitmap& other, Op op) {
+  std::vector<uint16_t> keys;
+  std::vector<Container> containers;
+  std::size_t i {0}, j {0};
+  while (i < keys_.size() || j < other.keys_.size()) {
+    if (j == other.keys_.size() ||
+        (i < keys_.size() && keys_[i] < other.keys_[j])) {
+      if (op != kAnd) {
+        keys.push_back(keys_[i]);
+        containers.push_back(std::move(containers_[i]));
+      }
+      ++i;
+    } else if (i == keys_.size() || other.keys_[j] < keys_[i]) {
+      if (op == kOr) {
+        keys.push_back(other.keys_[j]);
+        containers.push_back(other.containers_[j]);
+      }
+      ++j;
+    } else {
+      Container c = merge(containers_[i], other.containers_[j], op);
+      if (c.cardinality > 0) {
+        keys.push_back(keys_[i]);
+        containers.push_back(std::move(c));
+      }
+      ++i;
+      ++j;
+    }
+  }
+  keys_.swap(keys);
+  containers_.swap(containers);
+}
+
+bf::Bitmap& bf::Bitmap::operator|=(const Bitmap& other) {
+  combine(other, kOr);
+  return *this;
+}
+
+bf::Bitmap& bf::Bitmap::operator&=(const Bitmap& other) {
+  combine(other, kAnd);
+  return *this;
+}
+
+bf::Bitmap& bf::Bitmap::operator-=(const Bitmap& other) {
+  combine(other, kAndNot);
+  return *this;
+}
+
+uint64_t bf::Bitmap::and_cardinality(const Bitmap& a, const Bitmap& b) {
+  uint64_t total {0};
+  std::size_t i {0}, j {0};
+  while (i < a.keys_.size() && j < b.keys_.size()) {
+    if (a.keys_[i] < b.keys_[j]) {
+      ++i;
+    } else if (b.keys_[j] < a.keys_[i]) {
+      ++j;
+    } else {
+      const Container& x = a.containers_[i];
+      const Container& y = b.containers_[j];
+      if (x.dense() && y.dense()) {
+        for (std::size_t w = 0; w < kWords; ++w) {
+          total += __builtin_popcountll(x.bits[w] & y.bits[w]);
+        }
+      } else if (!x.dense() && !y.dense()) {
+        auto p = x.array.begin(), q = y.array.begin();
+        while (p != x.array.end() && q != y.array.end()) {
+          if (*p < *q) {
+            ++p;
+          } else if (*q < *p) {
+            ++q;
+          } else {
+            ++total;
+            ++p;
+            ++q;
+          }
+        }
+      } else {
+        const Container& sparse = x.dense() ? y : x;
+        const Container& dense = x.dense() ? x : y;
+        for (auto low : sparse.array) {
+          total += dense.contains(low);
+        }
+      }
+      ++i;
+      ++j;
+    }
+  }
+  return total;
+}
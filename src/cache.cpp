@@ -0,0 +1,59 @@
+/**
+ *  @file cache.cpp
+ *  @brief Least-recently-used cache of parsed input files
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <sys/stat.h>
+#include <climits>
+#include <cstdlib>
+#include <string>
+#include "bigfix/cache.h"
+
+/**
+ *  @details Modification times are compared to the nanosecond where the
+ *           platform records them, and to the second otherwise
+ */
+bool bf::fileKey(const std::string& filename, std::string* key) {
+  char path[PATH_MAX];
+  struct stat st;
+  if (realpath(filename.c_str(), path) == nullptr ||
+      stat(path, &st) != 0) {
+    return false;
+  }
+#if defined(__APPLE__)
+  long nanoseconds = st.st_mtimespec.tv_nsec;
+#elif defined(st_mtime)
+  // st_mtime is defined as st_mtim.tv_sec where nanoseconds are kept
+  long nanoseconds = st.st_mtim.tv_nsec;
+#else
+  long nanoseconds {0};
+#endif
+  *key = path;
+  key->push_back('\0');
+  *key += std::to_string(st.st_mtime) + "." + std::to_string(nanoseconds) +
+          ":" + std::to_string(st.st_size);
+  return true;
+}
@@ -0,0 +1,261 @@
+/**
+ *  @file catalog.cpp
+ *  @brief Compile-time perfect hash of the known computer group catalogue
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>  // NOLINT
+#include <map>
+#include <string>
+#include <vector>
+#include "bigfix/catalog.h"
+
+namespace {
+
+/** largest catalogue checked at compile time, within compiler limits */
+constexpr std::size_t kCheckedGroups {16384};
+
+static_assert(bf::catalog::kGroups > kCheckedGroups ||
+              bf::catalogValid(0, bf::catalog::kGroups),
+              "catalogdata.h is inconsistent, regenerate it with make catalog");
+
+/** number of seeds tried for one bucket before the slots are doubled */
+const uint64_t kMaxSeed {1 << 20};
+
+/**
+ *  @brief Smallest power of two no less than a number
+ *  @param n number to round up
+ *  @retval std::size_t power of two, at least one
+ */
+std::size_t roundUp(std::size_t n) {
+  std::size_t power {1};
+  while (power < n) {
+    power <<= 1;
+  }
+  return power;
+}
+
+/**
+ *  @brief Find a seed for every bucket so that all names get their own slot
+ *  @details Buckets are placed largest first, while most slots are free
+ *  @param hashes catalogHash() of each name
+ *  @param buckets number of buckets
+ *  @param slots number of slots
+ *  @param seeds receives the seed of each bucket
+ *  @param slot_group receives the name index in each slot
+ *  @retval bool false if some bucket could not be placed
+ */
+bool place(const std::vector<uint64_t>& hashes, std::size_t buckets,
+           std::size_t slots, std::vector<uint64_t>* seeds,
+           std::vector<int>* slot_group) {
+  std::vector<std::vector<std::size_t>> members(buckets);
+  for (std::size_t i = 0; i < hashes.size(); ++i) {
+    members[bf::catalogBucket(hashes[i], buckets)].push_back(i);
+  }
+  std::vector<std::size_t> order(buckets);
+  for (std::size_t b = 0; b < buckets; ++b) {
+    order[b] = b;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&members](std::size_t a, std::size_t b) {
+                     return members[a].size() > members[b].size();
+                   });
+  seeds->assign(buckets, 0);
+  slot_group->assign(slots, bf::kNotInCatalog);
+  std::vector<std::size_t> chosen;
+  for (std::size_t b : order) {
+    if (members[b].empty()) {
+      break;
+    }
+    bool placed {false};
+    for (uint64_t seed = 1; seed < kMaxSeed && !placed; ++seed) {
+      chosen.clear();
+      placed = true;
+      for (std::size_t i : members[b]) {
+        std::size_t slot = bf::catalogSlot(hashes[i], seed, slots);
+        if ((*slot_group)[slot] != bf::kNotInCatalog ||
+            std::find(chosen.begin(), chosen.end(), slot) != chosen.end()) {
+          placed = false;
+          break;
+        }
+        chosen.push_back(slot);
+      }
+      if (placed) {
+        (*seeds)[b] = seed;
+        for (std::size_t j = 0; j < chosen.size(); ++j) {
+          (*slot_group)[chosen[j]] = static_cast<int>(members[b][j]);
+        }
+      }
+    }
+    if (!placed) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ *  @brief Quote a name as a C++ string literal
+ *  @param name name to quote
+ *  @retval std::string literal, with octal escapes for unprintable bytes
+ */
+std::string literal(const std::string& name) {
+  std::string text {"\""};
+  for (char c : name) {
+    unsigned char u = static_cast<unsigned char>(c);
+    if (c == '"' || c == '\\') {
+      text.push_back('\\');
+      text.push_back(c);
+    } else if (u < 0x20 || u >= 0x7f) {
+      char escape[5];
+      snprintf(escape, sizeof(escape), "\\%03o", u);
+      text += escape;
+    } else {
+      text.push_back(c);
+    }
+  }
+  return text + "\"";
+}
+
+/**
+ *  @brief Format numbers as the body of an array initializer
+ *  @param items numbers to format
+ *  @retval std::string lines of comma-separated values
+ */
+template <typename T>
+std::string values(const std::vector<T>& items) {
+  std::string text;
+  std::string line {" "};
+  for (const auto& value : items) {
+    std::string item = " " + std::to_string(value) + ",";
+    if (line.length() + item.length() > 80) {
+      text += line + "\n";
+      line = " ";
+    }
+    line += item;
+  }
+  return text + line + "\n";
+}
+
+}  // namespace
+
+bf::CatalogCounts::CatalogCounts(std::map<std::string, uint32_t>* raw)
+    : raw_(raw), counts_(catalog::kGroups, 0), seen_(catalog::kGroups, 0) {
+}
+
+void bf::CatalogCounts::add(const char* name, std::size_t length,
+                            uint32_t count) {
+  int group = catalogFind(name, length);
+  if (group == kNotInCatalog) {
+    raw_->emplace(std::string(name, length), count);
+  } else if (!seen_[group]) {
+    seen_[group] = 1;
+    counts_[group] = count;
+  }
+}
+
+void bf::CatalogCounts::flush() {
+  for (std::size_t group = 0; group < catalog::kGroups; ++group) {
+    if (seen_[group]) {
+      raw_->emplace(std::string(catalog::kNames[group],
+                                catalog::kLengths[group]), counts_[group]);
+      seen_[group] = 0;
+    }
+  }
+}
+
+/**
+ *  @details Start with one slot per name and half as many buckets; the
+ *           tables are written as constexpr arrays in namespace catalog
+ */
+bool bf::writeCatalog(const std::vector<std::string>& names,
+                      const std::string& source, const std::string& filename) {
+  std::vector<uint64_t> hashes;
+  for (const auto& name : names) {
+    hashes.push_back(catalogHash(name.data(), name.length()));
+  }
+  std::size_t buckets = roundUp(std::max<std::size_t>(1, names.size() / 2));
+  std::size_t slots = roundUp(names.size());
+  std::vector<uint64_t> seeds;
+  std::vector<int> slot_group;
+  while (!place(hashes, buckets, slots, &seeds, &slot_group)) {
+    slots <<= 1;
+  }
+  std::string text;
+  text += "/**\n";
+  text += " *  @file catalogdata.h\n";
+  text += " *  @brief Perfect hash tables of the computer group catalogue\n";
+  text += " *  @details Generated by bfstats --emit-catalog from " + source +
+          ";\n";
+  text += " *           regenerate with \"make catalog\"\n";
+  text += " */\n\n";
+  text += "#ifndef BIGFIX_CATALOGDATA_H_\n";
+  text += "#define BIGFIX_CATALOGDATA_H_\n\n";
+  text += "#include <cstddef>\n";
+  text += "#include <cstdint>\n\n";
+  text += "namespace bf {\n";
+  text += "namespace catalog {\n\n";
+  text += "/** number of groups in the catalogue */\n";
+  text += "constexpr std::size_t kGroups {" + std::to_string(names.size()) +
+          "};\n\n";
+  text += "/** number of first-level buckets, a power of two */\n";
+  text += "constexpr std::size_t kBuckets {" + std::to_string(buckets) +
+          "};\n\n";
+  text += "/** number of slots, a power of two */\n";
+  text += "constexpr std::size_t kSlots {" + std::to_string(slots) + "};\n\n";
+  text += "/** displacement seed of each bucket */\n";
+  text += "constexpr uint64_t kSeeds[kBuckets] {\n" + values(seeds) + "};\n\n";
+  text += "/** group in each slot, -1 if the slot is empty */\n";
+  text += "constexpr int kSlotGroup[kSlots] {\n" + values(slot_group) +
+          "};\n\n";
+  std::vector<std::size_t> lengths;
+  text += "/** name of each group */\n";
+  text += "constexpr const char* kNames[] {\n";
+  for (const auto& name : names) {
+    text += "  " + literal(name) + ",\n";
+    lengths.push_back(name.length());
+  }
+  if (names.empty()) {
+    text += "  \"\",\n";
+    lengths.push_back(0);
+  }
+  text += "};\n\n";
+  text += "/** length of each name */\n";
+  text += "constexpr std::size_t kLengths[] {\n" + values(lengths) + "};\n\n";
+  text += "}  // namespace catalog\n";
+  text += "}  // namespace bf\n\n";
+  text += "#endif  // BIGFIX_CATALOGDATA_H_\n";
+  std::ofstream fs(filename, std::ios::out | std::ios::binary |
+                   std::ios::trunc);
+  if (!fs.is_open()) {
+    printf("Error: Could not open file %s\n", filename.c_str());
+    return false;
+  }
+  fs.write(text.data(), text.length());
+  return static_cast<bool>(fs);
+}
@@ -0,0 +1,177 @@
+/**
+ *  @file columns.cpp
+ *  @brief Selection of the group and count columns of a report table
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "bigfix/columns.h"
+#include "bigfix/output.h"
+
+namespace {
+
+/**
+ *  @brief Join header cells for a warning message
+ *  @param names header cells
+ *  @retval std::string cells separated by " | "
+ */
+std::string joined(const std::vector<std::string>& names) {
+  std::string text;
+  for (const auto& name : names) {
+    if (!text.empty()) {
+      text += " | ";
+    }
+    text += name;
+  }
+  return text;
+}
+
+/**
+ *  @brief Whether a character is a blank that may surround a header
+ *  @param c character to test
+ *  @retval bool true for spaces, tabs and line breaks
+ */
+inline bool blank(char c) {
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+}  // namespace
+
+bool bf::columnIndex(const std::string& column, std::size_t* index) {
+  if (column.empty() || column.length() > 9 ||
+      column.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  std::size_t position = std::stoul(column);
+  if (position == 0) {
+    return false;
+  }
+  *index = position - 1;
+  return true;
+}
+
+bool bf::columnMatches(const char* data, std::size_t length,
+                       const std::string& name) {
+  while (length > 0 && blank(*data)) {
+    ++data;
+    --length;
+  }
+  while (length > 0 && blank(data[length - 1])) {
+    --length;
+  }
+  return length == name.length() &&
+         std::equal(data, data + length, name.begin(), [](char a, char b) {
+           return tolower(static_cast<unsigned char>(a)) ==
+                  tolower(static_cast<unsigned char>(b));
+         });
+}
+
+bf::ColumnLayout::ColumnLayout(const ReportColumns& columns,
+                               const std::string& filename)
+    : columns_(columns), filename_(filename) {
+  if (!columns.group.empty() && !columnIndex(columns.group, &group_)) {
+    ready_ = false;
+  }
+  if (!columns.count.empty() && !columnIndex(columns.count, &count_)) {
+    ready_ = false;
+  }
+}
+
+bool bf::ColumnLayout::selected() const {
+  return !columns_.group.empty() || !columns_.count.empty();
+}
+
+bool bf::ColumnLayout::ready() const {
+  return ready_;
+}
+
+std::size_t bf::ColumnLayout::group() const {
+  return group_;
+}
+
+std::size_t bf::ColumnLayout::count() const {
+  return count_;
+}
+
+bool bf::ColumnLayout::locate(const std::string& name,
+                              const std::vector<std::string>& names,
+                              std::size_t* index) {
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    if (columnMatches(names[i].data(), names[i].length(), name)) {
+      *index = i;
+      return true;
+    }
+  }
+  message("Warning: %s: table header has no column named \"%s\"\n",
+          filename_.c_str(), name.c_str());
+  return false;
+}
+
+/**
+ *  @details Named columns are located afresh in every header row, so the
+ *           counts follow a column that moved, but the change is reported
+ */
+void bf::ColumnLayout::header(const std::vector<Cell>& cells) {
+  std::vector<std::string> names;
+  for (const auto& cell : cells) {
+    const char* data = cell.data;
+    std::size_t length = cell.length;
+    while (length > 0 && blank(*data)) {
+      ++data;
+      --length;
+    }
+    while (length > 0 && blank(data[length - 1])) {
+      --length;
+    }
+    names.emplace_back(data, length);
+  }
+  if (!header_.empty() && names != header_) {
+    message("Warning: %s: table header changed from \"%s\" to \"%s\"\n",
+            filename_.c_str(), joined(header_).c_str(),
+            joined(names).c_str());
+  }
+  header_ = names;
+  std::size_t index;
+  ready_ = true;
+  if (columnIndex(columns_.group, &index)) {
+    group_ = index;
+  } else if (!columns_.group.empty()) {
+    ready_ = locate(columns_.group, names, &group_) && ready_;
+  }
+  if (columnIndex(columns_.count, &index)) {
+    count_ = index;
+  } else if (!columns_.count.empty()) {
+    ready_ = locate(columns_.count, names, &count_) && ready_;
+  }
+  if (ready_ && std::max(group_, count_) >= names.size()) {
+    message("Warning: %s: table header has only %zu columns\n",
+            filename_.c_str(), names.size());
+  }
+}
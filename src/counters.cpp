@@ -0,0 +1,199 @@
+/**
+ *  @file counters.cpp
+ *  @brief Per-group counters shared by parallel parsing threads
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <unistd.h>
+#include <map>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include "bigfix/counters.h"
+
+namespace {
+
+/**
+ *  @brief Size of the cache private to one core
+ *  @retval std::size_t the level 2 cache size where the system reports it,
+ *          otherwise bf::kDefaultCoreCache
+ */
+std::size_t coreCache() {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (size > 0) {
+    return static_cast<std::size_t>(size);
+  }
+#endif
+  return bf::kDefaultCoreCache;
+}
+
+/**
+ *  @brief FNV-1a hash of a name, never zero since zero marks a free slot
+ *  @param name name to hash
+ *  @retval uint64_t hash value
+ */
+uint64_t hashName(const std::string& name) {
+  uint64_t hash {14695981039346656037ULL};
+  for (char c : name) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+  }
+  return hash != 0 ? hash : 1;
+}
+
+}  // namespace
+
+bf::CounterTable::CounterTable(std::size_t capacity)
+    : limit_(capacity > 0 ? capacity : 1) {
+  std::size_t slots {2};
+  while (slots < 2 * limit_) {
+    slots <<= 1;
+  }
+  slots_.reset(new Slot[slots]);
+  mask_ = slots - 1;
+}
+
+bf::CounterTable::~CounterTable() {
+  for (std::size_t i = 0; i <= mask_; ++i) {
+    delete slots_[i].name.load(std::memory_order_relaxed);
+  }
+}
+
+/**
+ *  @details The size check happens before claiming a slot, so the table can
+ *           briefly hold a few more than limit_ names when several threads
+ *           insert at once; there are always free slots left to end probing
+ */
+bool bf::CounterTable::add(const std::string& name, uint64_t count) {
+  uint64_t hash = hashName(name);
+  for (std::size_t i = hash & mask_, probes = 0; probes <= mask_;
+       i = (i + 1) & mask_, ++probes) {
+    Slot& slot = slots_[i];
+    uint64_t found = slot.hash.load(std::memory_order_acquire);
+    if (found == 0) {
+      if (size_.load(std::memory_order_relaxed) >= limit_) {
+        return false;
+      }
+      if (slot.hash.compare_exchange_strong(found, hash,
+                                            std::memory_order_acq_rel)) {
+        slot.count.fetch_add(count, std::memory_order_relaxed);
+        slot.name.store(new std::string(name), std::memory_order_release);
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+      // another thread claimed the slot first; found now holds its hash
+    }
+    if (found != hash) {
+      continue;
+    }
+    const std::string* other;
+    while ((other = slot.name.load(std::memory_order_acquire)) == nullptr) {
+      std::this_thread::yield();
+    }
+    if (*other == name) {
+      slot.count.fetch_add(count, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t bf::CounterTable::find(const std::string& name) const {
+  uint64_t hash = hashName(name);
+  for (std::size_t i = hash & mask_, probes = 0; probes <= mask_;
+       i = (i + 1) & mask_, ++probes) {
+    const Slot& slot = slots_[i];
+    uint64_t found = slot.hash.load(std::memory_order_acquire);
+    if (found == 0) {
+      return 0;
+    }
+    const std::string* other = slot.name.load(std::memory_order_acquire);
+    if (found == hash && other != nullptr && *other == name) {
+      return slot.count.load(std::memory_order_relaxed);
+    }
+  }
+  return 0;
+}
+
+std::size_t bf::CounterTable::size() const {
+  return size_.load(std::memory_order_relaxed);
+}
+
+void bf::CounterTable::collect(std::map<std::string, uint64_t>* counts) const {
+  for (std::size_t i = 0; i <= mask_; ++i) {
+    const std::string* name = slots_[i].name.load(std::memory_order_acquire);
+    if (name != nullptr) {
+      (*counts)[*name] += slots_[i].count.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bf::CounterStrategy bf::chooseStrategy(std::size_t workers,
+                                      std::size_t groups) {
+  if (workers <= 1) {
+    return CounterStrategy::kLocal;
+  }
+  static const std::size_t cache = coreCache();
+  return groups > cache / kLocalCounterBytes ? CounterStrategy::kShared
+                                             : CounterStrategy::kLocal;
+}
+
+bf::GroupCounters::GroupCounters(std::size_t workers, std::size_t groups,
+                                 CounterStrategy strategy)
+    : strategy_(strategy),
+      shared_(strategy == CounterStrategy::kShared ? groups : 1),
+      local_(strategy == CounterStrategy::kLocal ? workers : 0) {
+}
+
+bf::GroupCounters::GroupCounters(std::size_t workers, std::size_t groups)
+    : GroupCounters(workers, groups, chooseStrategy(workers, groups)) {
+}
+
+void bf::GroupCounters::add(std::size_t worker, const std::string& name,
+                            uint64_t count) {
+  if (strategy_ == CounterStrategy::kLocal) {
+    local_[worker].counts[name] += count;
+  } else if (!shared_.add(name, count)) {
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    overflow_[name] += count;
+  }
+}
+
+void bf::GroupCounters::collect(std::map<std::string, uint64_t>* counts) {
+  shared_.collect(counts);
+  for (const auto& group : overflow_) {
+    (*counts)[group.first] += group.second;
+  }
+  for (const auto& local : local_) {
+    for (const auto& group : local.counts) {
+      (*counts)[group.first] += group.second;
+    }
+  }
+}
+
+bf::CounterStrategy bf::GroupCounters::strategy() const {
+  return strategy_;
+}
@@ -0,0 +1,356 @@
+/**
+ *  @file csv.cpp
+ *  @brief Parser for Web Reports CSV exports
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>  // NOLINT
+#include <map>
+#include <sstream>
+#include <string>
+#include "bigfix/csv.h"
+#include "bigfix/input.h"
+#include "bigfix/output.h"
+
+namespace {
+
+/** number of bytes classified per step */
+const std::size_t kBlock {64};
+
+/**
+ *  @brief Positions of the characters that can delimit fields in one block
+ */
+struct Masks {
+  uint64_t quote;
+  uint64_t comma;
+  uint64_t newline;
+};
+
+/**
+ *  @brief Classify one block of kBlock bytes
+ *  @param block start of the block
+ *  @retval Masks bit i is set where byte i is a quote, comma or newline
+ */
+inline Masks classify(const char* block) {
+  Masks m {0, 0, 0};
+#ifdef __SSE2__
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i comma = _mm_set1_epi8(',');
+  const __m128i newline = _mm_set1_epi8('\n');
+  for (int i = 0; i < 4; ++i) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block) + i);
+    int shift = 16 * i;
+    m.quote |= static_cast<uint64_t>(static_cast<uint16_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+    m.comma |= static_cast<uint64_t>(static_cast<uint16_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(v, comma)))) << shift;
+    m.newline |= static_cast<uint64_t>(static_cast<uint16_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)))) << shift;
+  }
+#else
+  for (std::size_t i = 0; i < kBlock; ++i) {
+    uint64_t bit = uint64_t {1} << i;
+    m.quote |= block[i] == '"' ? bit : 0;
+    m.comma |= block[i] == ',' ? bit : 0;
+    m.newline |= block[i] == '\n' ? bit : 0;
+  }
+#endif
+  return m;
+}
+
+/**
+ *  @brief Running XOR of every bit with all lower bits
+ *  @details Applied to the quote mask this sets every bit between an opening
+ *           and a closing quote; a doubled quote inside a field toggles the
+ *           state off and straight back on, so it needs no special case
+ *  @param x quote mask
+ *  @retval uint64_t mask of bytes inside quotes, including opening quotes
+ */
+inline uint64_t prefixXor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+/**
+ *  @brief Remove surrounding quotes and undouble embedded ones
+ *  @param data start of the field
+ *  @param length length of the field
+ *  @retval std::string field value
+ */
+std::string unquote(const char* data, std::size_t length) {
+  if (length < 2 || data[0] != '"' || data[length - 1] != '"') {
+    return std::string(data, length);
+  }
+  std::string value;
+  value.reserve(length - 2);
+  for (std::size_t i = 1; i + 1 < length; ++i) {
+    value.push_back(data[i]);
+    if (data[i] == '"' && data[i + 1] == '"') {
+      ++i;
+    }
+  }
+  return value;
+}
+
+/**
+ *  @brief Parse a count that may be quoted and carry thousands separators
+ *  @param data start of the field
+ *  @param length length of the field
+ *  @param value receives the count
+ *  @retval bool true if the field holds digits and nothing but separators,
+ *          quotes and blanks around them, and the count fits in uint32_t
+ */
+bool parseCount(const char* data, std::size_t length, uint32_t* value) {
+  std::size_t i {0}, digits {0};
+  uint64_t count {0};
+  *value = 0;
+  while (i < length && (data[i] == '"' || data[i] == ' ')) {
+    ++i;
+  }
+  for (; i < length; ++i) {
+    if (data[i] >= '0' && data[i] <= '9') {
+      count = count * 10 + static_cast<uint64_t>(data[i] - '0');
+      if (count > UINT32_MAX) {
+        return false;
+      }
+      ++digits;
+    } else if (data[i] != ',') {
+      break;
+    }
+  }
+  while (i < length && (data[i] == '"' || data[i] == ' ')) {
+    ++i;
+  }
+  *value = static_cast<uint32_t>(count);
+  return digits > 0 && i == length;
+}
+
+/**
+ *  @brief Whether a header field names a column, ignoring case and blanks
+ *  @param data start of the header field
+ *  @param length length of the header field
+ *  @param name column name to match
+ *  @retval bool true if they match
+ */
+bool matches(const char* data, std::size_t length, const std::string& name) {
+  std::string field = unquote(data, length);
+  std::size_t first = field.find_first_not_of(" \t");
+  std::size_t last = field.find_last_not_of(" \t");
+  if (first == std::string::npos) {
+    return name.empty();
+  }
+  field = field.substr(first, last - first + 1);
+  return field.length() == name.length() &&
+         std::equal(field.begin(), field.end(), name.begin(),
+                    [](char a, char b) {
+                      return tolower(static_cast<unsigned char>(a)) ==
+                             tolower(static_cast<unsigned char>(b));
+                    });
+}
+
+/**
+ *  @brief Assembles rows from the field boundaries found by the scanner
+ */
+class Rows {
+ private:
+  const char* data_;
+  const bf::ReportColumns& columns_;
+  std::map<std::string, uint32_t>* raw_;
+  bool header_;
+  std::size_t group_column_ {0}, count_column_ {1};
+  bool group_found_ {false}, count_found_ {false};
+  std::size_t field_ {0}, start_ {0};
+  const char* group_ {nullptr};
+  std::size_t group_length_ {0};
+  const char* count_ {nullptr};
+  std::size_t count_length_ {0};
+
+ public:
+  Rows(const char* data, const bf::ReportColumns& columns,
+       std::map<std::string, uint32_t>* raw)
+      : data_(data), columns_(columns), raw_(raw) {
+    // columns given by position need no header
+    group_found_ = bf::columnIndex(columns.group, &group_column_);
+    count_found_ = bf::columnIndex(columns.count, &count_column_);
+    header_ = (!columns.group.empty() && !group_found_) ||
+              (!columns.count.empty() && !count_found_);
+  }
+
+  /**
+   *  @brief Close the field ending at end
+   *  @param end position of the delimiter ending the field
+   *  @param row_end whether the delimiter also ends the row
+   *  @retval bool false if the header lacks a named column
+   */
+  bool field(std::size_t end, bool row_end) {
+    const char* text = data_ + start_;
+    std::size_t length = end - start_;
+    if (row_end && length > 0 && text[length - 1] == '\r') {
+      --length;
+    }
+    if (header_) {
+      if (!group_found_ && !columns_.group.empty() &&
+          matches(text, length, columns_.group)) {
+        group_column_ = field_;
+        group_found_ = true;
+      }
+      if (!count_found_ && !columns_.count.empty() &&
+          matches(text, length, columns_.count)) {
+        count_column_ = field_;
+        count_found_ = true;
+      }
+    } else if (field_ == group_column_) {
+      group_ = text;
+      group_length_ = length;
+    } else if (field_ == count_column_) {
+      count_ = text;
+      count_length_ = length;
+    }
+    ++field_;
+    start_ = end + 1;
+    if (row_end) {
+      return row();
+    }
+    return true;
+  }
+
+  /**
+   *  @brief Finish the current row
+   *  @retval bool false if the header lacks a named column
+   */
+  bool row() {
+    if (header_) {
+      header_ = false;
+      if ((!columns_.group.empty() && !group_found_) ||
+          (!columns_.count.empty() && !count_found_)) {
+        return false;
+      }
+    } else if (group_ != nullptr && count_ != nullptr) {
+      uint32_t count {0};
+      if (parseCount(count_, count_length_, &count)) {
+        raw_->emplace(unquote(group_, group_length_), count);
+      }
+    }
+    field_ = 0;
+    group_ = count_ = nullptr;
+    return true;
+  }
+
+  /**
+   *  @brief Whether data remains that has not been assigned to a row
+   *  @param length length of the data
+   *  @retval bool true if the last row lacks a terminating newline
+   */
+  bool open(std::size_t length) const {
+    return start_ < length || field_ > 0;
+  }
+};
+
+}  // namespace
+
+bool bf::isCsv(const std::string& filename) {
+  std::string name = uncompressedName(filename);
+  return name.length() > kCsvExt.length() &&
+         name.compare(name.length() - kCsvExt.length(), kCsvExt.length(),
+                      kCsvExt) == 0;
+}
+
+/**
+ *  @details The inside-quotes state is carried from one block to the next as
+ *           an all-ones or all-zeros mask; the final partial block is copied
+ *           into a zero-padded buffer so every load is a full block
+ */
+bool bf::parseCsv(const char* data, std::size_t length,
+                  const ReportColumns& columns,
+                  std::map<std::string, uint32_t>* raw) {
+  Rows rows(data, columns, raw);
+  uint64_t inside {0};
+  char tail[kBlock];
+  for (std::size_t base = 0; base < length; base += kBlock) {
+    const char* block = data + base;
+    if (length - base < kBlock) {
+      memset(tail, 0, sizeof(tail));
+      memcpy(tail, block, length - base);
+      block = tail;
+    }
+    Masks m = classify(block);
+    uint64_t quoted = prefixXor(m.quote) ^ inside;
+    inside = static_cast<uint64_t>(static_cast<int64_t>(quoted) >> 63);
+    uint64_t structural = (m.comma | m.newline) & ~quoted;
+    while (structural != 0) {
+      int bit = __builtin_ctzll(structural);
+      if (!rows.field(base + bit, (m.newline >> bit) & 1)) {
+        return false;
+      }
+      structural &= structural - 1;
+    }
+  }
+  if (rows.open(length)) {
+    return rows.field(length, true);
+  }
+  return true;
+}
+
+bool bf::loadCsv(const std::string& filename, const ReportColumns& columns,
+                 std::map<std::string, uint32_t>* raw) {
+  std::ifstream fs(filename, std::ios::in | std::ios::binary);
+  if (!fs.is_open()) {
+    message("Error: Could not open file %s\n", filename.c_str());
+    return false;
+  }
+  std::ostringstream contents;
+  contents << fs.rdbuf();
+  std::string buffer = contents.str();
+  std::string plain;
+  const std::string* text = &buffer;
+  if (detect(reinterpret_cast<const unsigned char*>(buffer.data()),
+             buffer.length()) != Compression::kNone) {
+    if (!decompress(buffer, &plain)) {
+      message("Error: File %s is truncated or corrupt\n", filename.c_str());
+      return false;
+    }
+    text = &plain;
+  }
+  if (!parseCsv(text->data(), text->length(), columns, raw)) {
+    message("Error: File %s has no column named \"%s\" or \"%s\"\n",
+            filename.c_str(), columns.group.c_str(), columns.count.c_str());
+    return false;
+  }
+  return true;
+}
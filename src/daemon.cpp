@@ -0,0 +1,309 @@
+/**
+ *  @file daemon.cpp
+ *  @brief Unix-domain socket daemon and client for repeated report runs
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+#include "bigfix/daemon.h"
+
+namespace {
+
+/** largest request accepted by the daemon */
+const uint32_t kMaxRequest {1024 * 1024};
+
+/**
+ *  @brief Write a whole buffer, retrying short and interrupted writes
+ *  @param fd descriptor to write to
+ *  @param data start of the buffer
+ *  @param length length of the buffer
+ *  @retval bool false if the descriptor was closed or failed
+ */
+bool writeAll(int fd, const char* data, std::size_t length) {
+  while (length > 0) {
+    ssize_t n = write(fd, data, length);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    length -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+/**
+ *  @brief Read exactly length bytes, retrying short and interrupted reads
+ *  @param fd descriptor to read from
+ *  @param data receives the bytes
+ *  @param length number of bytes to read
+ *  @retval bool false if the descriptor was closed or failed first
+ */
+bool readAll(int fd, char* data, std::size_t length) {
+  while (length > 0) {
+    ssize_t n = read(fd, data, length);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    length -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+/**
+ *  @brief Fill in the address of a socket path
+ *  @param path socket path
+ *  @param address receives the address
+ *  @retval bool false if the path is too long
+ */
+bool socketAddress(const std::string& path, struct sockaddr_un* address) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (path.length() >= sizeof(address->sun_path)) {
+    printf("Error: Socket path %s is too long\n", path.c_str());
+    return false;
+  }
+  memcpy(address->sun_path, path.c_str(), path.length());
+  return true;
+}
+
+/**
+ *  @brief Whether a client runs as the same user as the daemon
+ *  @details The socket is already private to that user; where the kernel
+ *           reports the peer's credentials they are checked as well
+ *  @param client connected client socket
+ *  @retval bool false if the client belongs to another user
+ */
+bool trusted(int client) {
+#ifdef SO_PEERCRED
+  struct ucred peer;
+  socklen_t length = sizeof(peer);
+  if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &length) != 0) {
+    return false;
+  }
+  return peer.uid == geteuid();
+#else
+  (void)client;
+  return true;
+#endif
+}
+
+/**
+ *  @brief Read one request and run it with stdout redirected to the client
+ *  @details A request that throws is answered with an error instead of
+ *           ending the daemon
+ *  @param client connected client socket
+ *  @param handler called with the arguments of the request
+ */
+void answer(int client, const bf::Request& handler) {
+  uint32_t length {0};
+  if (!readAll(client, reinterpret_cast<char*>(&length), sizeof(length)) ||
+      length == 0 || length > kMaxRequest) {
+    return;
+  }
+  std::string payload(length, '\0');
+  if (!readAll(client, &payload[0], length)) {
+    return;
+  }
+  std::vector<std::string> fields;
+  std::size_t start {0};
+  while (start < payload.length()) {
+    std::size_t end = payload.find('\0', start);
+    if (end == std::string::npos) {
+      end = payload.length();
+    }
+    fields.push_back(payload.substr(start, end - start));
+    start = end + 1;
+  }
+  fflush(stdout);
+  int saved = dup(STDOUT_FILENO);
+  dup2(client, STDOUT_FILENO);
+  int status {1};
+  if (fields.empty() || chdir(fields.front().c_str()) != 0) {
+    printf("Error: Could not change to the client's working directory\n");
+  } else {
+    fields.erase(fields.begin());
+    try {
+      status = handler(fields);
+    } catch (const std::exception& e) {
+      printf("Error: Request failed: %s\n", e.what());
+      status = 1;
+    } catch (...) {
+      printf("Error: Request failed\n");
+      status = 1;
+    }
+  }
+  fflush(stdout);
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+  char code = static_cast<char>(status);
+  writeAll(client, &code, 1);
+}
+
+}  // namespace
+
+/**
+ *  @details The socket is created readable and writable by its owner only,
+ *           since a request runs with the daemon's privileges. A client that
+ *           goes away mid-reply must not kill the daemon, so SIGPIPE is
+ *           ignored and failed writes are simply abandoned; one that stops
+ *           sending or reading times out so the next client is served.
+ */
+bool bf::serve(const std::string& path, Request handler) {
+  struct sockaddr_un address;
+  if (!socketAddress(path, &address)) {
+    return false;
+  }
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    printf("Error: Could not create socket %s\n", path.c_str());
+    return false;
+  }
+  unlink(path.c_str());
+  mode_t mask = umask(S_IRWXG | S_IRWXO);
+  bool bound = bind(listener, reinterpret_cast<struct sockaddr*>(&address),
+                    sizeof(address)) == 0;
+  umask(mask);
+  if (!bound || chmod(path.c_str(), S_IRUSR | S_IWUSR) != 0 ||
+      listen(listener, SOMAXCONN) != 0) {
+    printf("Error: Could not listen on socket %s\n", path.c_str());
+    close(listener);
+    return false;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  char directory[PATH_MAX];
+  while (true) {
+    int client = accept(listener, nullptr, nullptr);
+    if (client < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      printf("Error: Could not accept connections on socket %s\n",
+             path.c_str());
+      break;
+    }
+    if (!trusted(client)) {
+      close(client);
+      continue;
+    }
+    struct timeval timeout {kClientTimeout, 0};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    // requests change directory, so return to ours between them
+    bool restore = getcwd(directory, sizeof(directory)) != nullptr;
+    answer(client, handler);
+    close(client);
+    if (restore && chdir(directory) != 0) {
+      printf("Warning: Could not return to directory %s\n", directory);
+    }
+  }
+  close(listener);
+  unlink(path.c_str());
+  return false;
+}
+
+/**
+ *  @details The last byte received is the exit status, so output is copied
+ *           one byte behind what has been read
+ */
+int bf::callDaemon(const std::string& path,
+                   const std::vector<std::string>& args) {
+  struct sockaddr_un address;
+  if (!socketAddress(path, &address)) {
+    return 1;
+  }
+  char directory[PATH_MAX];
+  if (getcwd(directory, sizeof(directory)) == nullptr) {
+    printf("Error: Could not read the working directory\n");
+    return 1;
+  }
+  std::string payload(directory);
+  payload.push_back('\0');
+  for (const auto& arg : args) {
+    payload += arg;
+    payload.push_back('\0');
+  }
+  uint32_t length = static_cast<uint32_t>(payload.length());
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 ||
+      connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+              sizeof(address)) != 0) {
+    printf("Error: Could not connect to socket %s\n", path.c_str());
+    if (fd >= 0) {
+      close(fd);
+    }
+    return 1;
+  }
+  if (!writeAll(fd, reinterpret_cast<const char*>(&length), sizeof(length)) ||
+      !writeAll(fd, payload.data(), payload.length())) {
+    printf("Error: Could not send request to socket %s\n", path.c_str());
+    close(fd);
+    return 1;
+  }
+  std::vector<char> buffer(64 * 1024);
+  bool any {false};
+  char last {0};
+  ssize_t n;
+  while ((n = read(fd, buffer.data(), buffer.size())) != 0) {
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (any) {
+      fwrite(&last, 1, 1, stdout);
+    }
+    fwrite(buffer.data(), 1, n - 1, stdout);
+    last = buffer[n - 1];
+    any = true;
+  }
+  close(fd);
+  if (!any || n < 0) {
+    printf("Error: Daemon on socket %s did not complete the request\n",
+           path.c_str());
+    return 1;
+  }
+  return static_cast<unsigned char>(last);
+}
@@ -0,0 +1,361 @@
+/**
+ *  @file endpoints.cpp
+ *  @brief Per-endpoint report ingestion with exact distinct counts
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "bigfix/bigfixstats.h"
+#include "bigfix/endpoints.h"
+#include "bigfix/input.h"
+#include "bigfix/output.h"
+#include "bigfix/tokenizer.h"
+
+bf::EndpointSet::EndpointSet(bool approximate) : approximate_(approximate) {
+}
+
+uint32_t bf::EndpointSet::intern(const std::string& name) {
+  std::size_t known = names_.size();
+  uint32_t id = names_.intern(name);
+  if (names_.size() > known) {
+    if (approximate_) {
+      sketches_.emplace_back();
+    } else {
+      groups_.emplace_back();
+      pending_.emplace_back();
+    }
+  }
+  return id;
+}
+
+void bf::EndpointSet::add(uint32_t computer, const std::string& group) {
+  uint32_t id = intern(group);
+  if (approximate_) {
+    sketches_[id].add(computer);
+  } else if (spilled_.budget() > 0) {
+    spilled_.add(static_cast<uint64_t>(id) << 32 | computer);
+  } else {
+    pending_[id].push_back(computer);
+  }
+}
+
+void bf::EndpointSet::set_budget(std::size_t bytes) {
+  spilled_ = ExternalSort(bytes);
+}
+
+std::size_t bf::EndpointSet::budget() const {
+  return spilled_.budget();
+}
+
+/**
+ *  @details New computers are appended to an empty bitmap and then unioned
+ *           in, since inserting into a bitmap already filled by an earlier
+ *           export is far slower. Spilled pairs are keyed by group then
+ *           computer, so the merge visits each group's computers in order
+ */
+bool bf::EndpointSet::flush() {
+  for (std::size_t id = 0; id < pending_.size(); ++id) {
+    std::vector<uint32_t>& computers = pending_[id];
+    if (computers.empty()) {
+      continue;
+    }
+    std::sort(computers.begin(), computers.end());
+    Bitmap added;
+    for (auto computer : computers) {
+      added.add(computer);
+    }
+    groups_[id] |= added;
+    std::vector<uint32_t>().swap(computers);
+  }
+  Bitmap added;
+  uint32_t group {0};
+  bool merged = spilled_.merge([this, &added, &group](uint64_t key) {
+    if (key >> 32 != group) {
+      groups_[group] |= added;
+      added = Bitmap();
+      group = static_cast<uint32_t>(key >> 32);
+    }
+    added.add(static_cast<uint32_t>(key));
+  });
+  if (group < groups_.size()) {
+    groups_[group] |= added;
+  }
+  return merged;
+}
+
+void bf::EndpointSet::merge(const EndpointSet& other) {
+  for (uint32_t id = 0; id < other.names_.size(); ++id) {
+    if (other.approximate_) {
+      merge(other.names_.name(id), other.sketches_[id]);
+    } else {
+      merge(other.names_.name(id), other.groups_[id]);
+    }
+  }
+}
+
+void bf::EndpointSet::merge(const std::string& name, const Bitmap& members) {
+  uint32_t id = intern(name);
+  if (!approximate_) {
+    groups_[id] |= members;
+    return;
+  }
+  std::vector<uint32_t> computers;
+  members.values(&computers);
+  for (auto computer : computers) {
+    sketches_[id].add(computer);
+  }
+}
+
+bool bf::EndpointSet::merge(const std::string& name,
+                            const HyperLogLog& sketch) {
+  if (!approximate_) {
+    this->sketch();
+  }
+  return sketches_[intern(name)].merge(sketch);
+}
+
+void bf::EndpointSet::sketch() {
+  if (approximate_) {
+    return;
+  }
+  flush();
+  std::vector<uint32_t> computers;
+  sketches_.assign(groups_.size(), HyperLogLog());
+  for (std::size_t id = 0; id < groups_.size(); ++id) {
+    groups_[id].values(&computers);
+    for (auto computer : computers) {
+      sketches_[id].add(computer);
+    }
+  }
+  std::vector<Bitmap>().swap(groups_);
+  std::vector<std::vector<uint32_t>>().swap(pending_);
+  approximate_ = true;
+}
+
+std::size_t bf::EndpointSet::size() const {
+  return names_.size();
+}
+
+const std::string& bf::EndpointSet::name(uint32_t group) const {
+  return names_.name(group);
+}
+
+const bf::Bitmap& bf::EndpointSet::members(uint32_t group) const {
+  return groups_[group];
+}
+
+const bf::HyperLogLog& bf::EndpointSet::sketch(uint32_t group) const {
+  return sketches_[group];
+}
+
+bool bf::EndpointSet::approximate() const {
+  return approximate_;
+}
+
+double bf::EndpointSet::error() const {
+  return approximate_ ? HyperLogLog().error() : 0;
+}
+
+uint64_t bf::EndpointSet::distinct(
+    const std::vector<std::string>& names) const {
+  Bitmap all;
+  HyperLogLog sketch;
+  for (const auto& name : names) {
+    uint32_t id = names_.find(name);
+    if (id == Interner::kMissing) {
+      continue;
+    }
+    if (approximate_) {
+      sketch.merge(sketches_[id]);
+    } else {
+      all |= groups_[id];
+    }
+  }
+  return approximate_ ? sketch.estimate() : all.cardinality();
+}
+
+uint64_t bf::EndpointSet::distinct() const {
+  std::vector<std::string> names;
+  for (uint32_t id = 0; id < names_.size(); ++id) {
+    names.push_back(names_.name(id));
+  }
+  return distinct(names);
+}
+
+void bf::EndpointSet::counts(std::map<std::string, uint32_t>* raw) const {
+  for (uint32_t id = 0; id < names_.size(); ++id) {
+    uint64_t count = approximate_ ? sketches_[id].estimate()
+                                  : groups_[id].cardinality();
+    (*raw)[names_.name(id)] = static_cast<uint32_t>(count);
+  }
+}
+
+/**
+ *  @details A name in double quotes runs to the next quote, so it may hold
+ *           the operator characters; the quote must then be followed by an
+ *           operator or the end of the expression
+ */
+bool bf::EndpointSet::count(const std::string& expression,
+                            uint64_t* result) const {
+  Bitmap set;
+  std::vector<std::string> names;
+  char op {'|'};
+  std::size_t start {0};
+  while (start <= expression.length()) {
+    std::string name;
+    std::size_t end;
+    if (start < expression.length() && expression[start] == '"') {
+      std::size_t quote = expression.find('"', start + 1);
+      if (quote == std::string::npos) {
+        return false;
+      }
+      name = expression.substr(start + 1, quote - start - 1);
+      end = quote + 1;
+      if (end < expression.length() &&
+          std::strchr("|&-", expression[end]) == nullptr) {
+        return false;
+      }
+    } else {
+      end = expression.find_first_of("|&-", start);
+      if (end == std::string::npos) {
+        end = expression.length();
+      }
+      name = expression.substr(start, end - start);
+    }
+    uint32_t id = names_.find(name);
+    if (id == Interner::kMissing || (approximate_ && op != '|')) {
+      return false;
+    }
+    names.push_back(name);
+    if (approximate_) {
+      // unions of sketches are merged by distinct() below
+    } else if (op == '|') {
+      set |= groups_[id];
+    } else if (op == '&') {
+      set &= groups_[id];
+    } else {
+      set -= groups_[id];
+    }
+    if (end < expression.length()) {
+      op = expression[end];
+    }
+    start = end + 1;
+  }
+  *result = approximate_ ? distinct(names) : set.cardinality();
+  return true;
+}
+
+/**
+ *  @details Rows are split into cells in place; rows whose first cell is not
+ *           a computer ID, such as headers, are skipped
+ */
+bool bf::loadEndpoints(const std::string& filename, EndpointSet* endpoints) {
+  Input fs(filename);
+  if (!fs.is_open()) {
+    message("Error: Could not open file %s\n", filename.c_str());
+    return false;
+  }
+  std::string line {};
+  std::string group {};
+  std::vector<Cell> cells;
+  auto blank = [](char c) { return isspace(static_cast<unsigned char>(c)); };
+  while (fs.getline(&line)) {
+    if (!isRecord<HtmlSchema>(line.data(), line.length())) {
+      continue;
+    }
+    splitCells<HtmlSchema>(line.data(), line.length(), &cells);
+    uint32_t computer {0};
+    if (cells.size() < 3 ||
+        !parseNumber(cells[0].data, cells[0].length, &computer)) {
+      continue;
+    }
+    // groups are separated by kGroupDelim, with surrounding blanks ignored
+    const char* groups = cells[2].data;
+    std::size_t length = cells[2].length, start {0};
+    while (start < length) {
+      std::size_t end = start;
+      while (end < length && groups[end] != kGroupDelim) {
+        ++end;
+      }
+      std::size_t first = start, last = end;
+      while (first < last && blank(groups[first])) {
+        ++first;
+      }
+      while (last > first && blank(groups[last - 1])) {
+        --last;
+      }
+      if (last > first) {
+        group.assign(groups + first, last - first);
+        endpoints->add(computer, group);
+      }
+      start = end + 1;
+    }
+  }
+  bool flushed = endpoints->flush();
+  if (fs.failed()) {
+    message("Error: File %s is truncated or corrupt\n", filename.c_str());
+    return false;
+  }
+  return flushed;
+}
+
+/**
+ *  @details Each worker loads whole files into its own set, so no locking is
+ *           needed while parsing; the per-worker sets are merged at the end
+ *           and each file's messages are printed in file order
+ */
+bool bf::loadEndpoints(const std::vector<std::string>& filenames,
+                       ThreadPool* pool, EndpointSet* endpoints) {
+  // each worker gets an equal share of the memory budget
+  EndpointSet empty(endpoints->approximate());
+  if (endpoints->budget() > 0) {
+    empty.set_budget(std::max<std::size_t>(endpoints->budget() / pool->size(),
+                                           sizeof(uint64_t)));
+  }
+  std::vector<EndpointSet> partial(pool->size(), empty);
+  std::vector<std::string> messages(filenames.size());
+  std::atomic<bool> ok {true};
+  pool->run(filenames.size(), [&](std::size_t index, std::size_t worker) {
+    DeferMessages defer(&messages[index]);
+    if (!loadEndpoints(filenames[index], &partial[worker])) {
+      ok = false;
+    }
+  });
+  for (const auto& text : messages) {
+    printf("%s", text.c_str());
+  }
+  for (const auto& set : partial) {
+    endpoints->merge(set);
+  }
+  return ok;
+}
@@ -0,0 +1,337 @@
+/**
+ *  @file grouptable.cpp
+ *  @brief Column-oriented storage for computer group deployment counts
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "bigfix/bigfixstats.h"
+#include "bigfix/grouptable.h"
+
+ComputerGroup::ComputerGroup(GroupTable* table, std::size_t row)
+    : table_(table), row_(row) {
+}
+
+/**
+ *  @details Counts and percentages are formatted only for the rows shown; the
+ *           OS name is displayed with a trailing asterisk
+ */
+uint8_t ComputerGroup::widest(unsigned rows) const {
+  const std::string& name = this->name();
+  std::size_t top = name.length() + (name == "OS" ? 1 : 0);
+  if (rows & bf::kCurrentRow) {
+    top = std::max(top, bf::format(this->current()).length());
+  }
+  if (rows & bf::kTargetRow) {
+    top = std::max(top, bf::format(this->target()).length());
+  }
+  if (rows & bf::kPercentRow) {
+    top = std::max(top, this->percent_text().length());
+  }
+  return static_cast<uint8_t>(top);
+}
+
+const std::string& ComputerGroup::name() const {
+  return table_->names_->name(table_->name_id_[row_]);
+}
+
+std::string ComputerGroup::formatted_name(uint8_t width) const {
+  const std::string& name = this->name();
+  std::string ret;
+  if (name == "OS") {
+    ret = name + "*" + std::string(width - name.length() - 1, ' ');
+  } else {
+    ret = name + std::string(width - name.length(), ' ');
+  }
+  return ret;
+}
+
+uint32_t ComputerGroup::current() const {
+  return table_->current_[row_];
+}
+
+std::string ComputerGroup::formatted_current(uint8_t width) const {
+  std::string output = bf::format(this->current());
+  return output + std::string(width - output.length() + 1, ' ');
+}
+
+uint32_t ComputerGroup::target() const {
+  return table_->target_[row_];
+}
+
+std::string ComputerGroup::formatted_target(uint8_t width) const {
+  std::string output = bf::format(this->target());
+  return output + std::string(width - output.length() + 1, ' ');
+}
+
+/**
+ *  @details Percentages are computed for the whole table at once, the first
+ *           time one is needed after any count has changed
+ */
+uint16_t ComputerGroup::percent() const {
+  if (table_->stale_) {
+    table_->compute_percent();
+  }
+  return table_->percent_[row_];
+}
+
+bf::Band ComputerGroup::band() const {
+  if (table_->stale_) {
+    table_->compute_percent();
+  }
+  return static_cast<bf::Band>(table_->band_[row_]);
+}
+
+/**
+ *  @details Wrap the bold percentage in a Confluence color macro when the
+ *           table has deployment bands
+ */
+std::string ComputerGroup::percent_text() const {
+  std::string output = "*" + std::to_string(this->percent()) + "*";
+  if (table_->banded_) {
+    const char* colors[] {"red", "orange", "green"};
+    output = std::string("{color:") + colors[static_cast<int>(this->band())] +
+             "}" + output + "{color}";
+  }
+  return output;
+}
+
+std::string ComputerGroup::formatted_percent(uint8_t width) const {
+  std::string output = this->percent_text();
+  return output + std::string(width - output.length() + 1, ' ');
+}
+
+void ComputerGroup::set_current(uint32_t current) {
+  table_->current_[row_] = current;
+  table_->stale_ = true;
+}
+
+void ComputerGroup::set_target(uint32_t target) {
+  table_->target_[row_] = target;
+  table_->stale_ = true;
+}
+
+/**
+ *  @details Copies share the names of the table they were copied from, so a
+ *           copy of a cached target table costs only its integer columns
+ */
+uint32_t GroupTable::intern(const std::string& name) {
+  uint32_t id = names_->find(name);
+  if (id != bf::Interner::kMissing) {
+    return id;
+  }
+  if (names_.use_count() > 1) {
+    names_ = std::make_shared<bf::Interner>(*names_);
+  }
+  return names_->intern(name);
+}
+
+void GroupTable::reserve(const std::string& name) {
+  intern(name);
+}
+
+ComputerGroup GroupTable::add(const std::string& name) {
+  uint32_t id = intern(name);
+  if (id >= row_of_.size()) {
+    row_of_.resize(id + 1, bf::kNoRow);
+  }
+  if (row_of_[id] == bf::kNoRow) {
+    row_of_[id] = name_id_.size();
+  }
+  name_id_.push_back(id);
+  current_.push_back(0);
+  target_.push_back(0);
+  percent_.push_back(0);
+  band_.push_back(0);
+  return ComputerGroup(this, name_id_.size() - 1);
+}
+
+/**
+ *  @details One hash probe of the interner, then a direct array lookup
+ */
+std::size_t GroupTable::find(const std::string& name) const {
+  uint32_t id = names_->find(name);
+  return id < row_of_.size() ? row_of_[id] : bf::kNoRow;
+}
+
+ComputerGroup GroupTable::operator[](std::size_t row) {
+  return ComputerGroup(this, row);
+}
+
+std::size_t GroupTable::size() const {
+  return name_id_.size();
+}
+
+/**
+ *  @details Plain reduction over a contiguous array so it vectorizes
+ */
+uint32_t GroupTable::total_current() const {
+  const uint32_t* current = current_.data();
+  std::size_t n = current_.size();
+  uint32_t total {0};
+  for (std::size_t i = 0; i < n; ++i) {
+    total += current[i];
+  }
+  return total;
+}
+
+/**
+ *  @details Plain reduction over a contiguous array so it vectorizes
+ */
+uint32_t GroupTable::total_target() const {
+  const uint32_t* target = target_.data();
+  std::size_t n = target_.size();
+  uint32_t total {0};
+  for (std::size_t i = 0; i < n; ++i) {
+    total += target[i];
+  }
+  return total;
+}
+
+/**
+ *  @details Classify and store one row; shared by the scalar tail and by
+ *           builds without SSE2 so both paths produce identical results
+ */
+void GroupTable::compute_row(std::size_t row) {
+  uint32_t target = target_[row];
+  double divisor = target != 0 ? target : 1;
+  double value = static_cast<double>(current_[row]) / divisor * 100 + 0.5;
+  value = value < bf::kMaxPercent ? value : bf::kMaxPercent;
+  uint16_t percent = target != 0 ? static_cast<uint16_t>(value) : 0;
+  percent_[row] = percent;
+  band_[row] = static_cast<uint8_t>((percent >= amber_) + (percent >= green_));
+}
+
+/**
+ *  @details Four rows per iteration with SSE2: counts are widened to double,
+ *           divided, scaled, rounded half up and saturated, then compared
+ *           against both band thresholds before being narrowed and stored.
+ *           Rows with a zero target divide by one and are masked to zero.
+ */
+void GroupTable::compute_percent() {
+  std::size_t n = name_id_.size();
+  std::size_t i {0};
+#ifdef __SSE2__
+  const uint32_t* current = current_.data();
+  const uint32_t* target = target_.data();
+  uint16_t* percent = percent_.data();
+  uint8_t* band = band_.data();
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i sign = _mm_set1_epi32(INT32_MIN);
+  const __m128i bias16 = _mm_set1_epi16(INT16_MIN);
+  const __m128i amber = _mm_set1_epi32(static_cast<int32_t>(amber_) - 1);
+  const __m128i green = _mm_set1_epi32(static_cast<int32_t>(green_) - 1);
+  const __m128d two31 = _mm_set1_pd(2147483648.0);
+  const __m128d scale = _mm_set1_pd(100);
+  const __m128d half = _mm_set1_pd(0.5);
+  const __m128d limit = _mm_set1_pd(bf::kMaxPercent);
+  // unsigned 32-bit lanes to double by flipping the sign bit and rebiasing
+  auto widen = [&](__m128i v, __m128d* lo, __m128d* hi) {
+    v = _mm_xor_si128(v, sign);
+    *lo = _mm_add_pd(_mm_cvtepi32_pd(v), two31);
+    *hi = _mm_add_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(v, 0x4e)), two31);
+  };
+  auto quotient = [&](__m128d c, __m128d t) {
+    __m128d q = _mm_add_pd(_mm_mul_pd(_mm_div_pd(c, t), scale), half);
+    return _mm_cvttpd_epi32(_mm_min_pd(q, limit));
+  };
+  for (; i + 4 <= n; i += 4) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current + i));
+    __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i));
+    __m128i none = _mm_cmpeq_epi32(t, zero);
+    t = _mm_or_si128(t, _mm_and_si128(none, one));
+    __m128d c_lo, c_hi, t_lo, t_hi;
+    widen(c, &c_lo, &c_hi);
+    widen(t, &t_lo, &t_hi);
+    __m128i p = _mm_unpacklo_epi64(quotient(c_lo, t_lo),
+                                   quotient(c_hi, t_hi));
+    p = _mm_andnot_si128(none, p);
+    // band is the number of thresholds reached: 0 red, 1 amber, 2 green
+    __m128i b = _mm_sub_epi32(zero, _mm_add_epi32(_mm_cmpgt_epi32(p, amber),
+                                                  _mm_cmpgt_epi32(p, green)));
+    // narrow to unsigned 16 bits using the signed pack on biased values
+    __m128i p16 = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(p, _mm_set1_epi32(
+        32768)), zero), bias16);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(percent + i), p16);
+    b = _mm_packus_epi16(_mm_packs_epi32(b, zero), zero);
+    int32_t bands = _mm_cvtsi128_si32(b);
+    memcpy(band + i, &bands, sizeof(bands));
+  }
+#endif
+  for (; i < n; ++i) {
+    compute_row(i);
+  }
+  stale_ = false;
+}
+
+void GroupTable::set_bands(uint16_t amber, uint16_t green) {
+  amber_ = amber;
+  green_ = green;
+  banded_ = true;
+  stale_ = true;
+}
+
+bool GroupTable::banded() const {
+  return banded_;
+}
+
+const bf::Interner& GroupTable::names() const {
+  return *names_;
+}
+
+const std::vector<uint32_t>& GroupTable::name_ids() const {
+  return name_id_;
+}
+
+const std::vector<uint32_t>& GroupTable::currents() const {
+  return current_;
+}
+
+const std::vector<uint32_t>& GroupTable::targets() const {
+  return target_;
+}
+
+const std::vector<uint16_t>& GroupTable::percents() {
+  if (stale_) {
+    compute_percent();
+  }
+  return percent_;
+}
+
+GroupTable::iterator GroupTable::begin() {
+  return iterator(this, 0);
+}
+
+GroupTable::iterator GroupTable::end() {
+  return iterator(this, name_id_.size());
+}
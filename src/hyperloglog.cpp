@@ -0,0 +1,120 @@
+/**
+ *  @file hyperloglog.cpp
+ *  @brief Mergeable approximate distinct counter for computer identifiers
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "bigfix/hyperloglog.h"
+
+namespace {
+
+/**
+ *  @brief Spread a computer ID over 64 bits (MurmurHash3 finalizer)
+ *  @param key computer ID
+ *  @retval uint64_t well-mixed hash
+ */
+uint64_t mix(uint64_t key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+
+}  // namespace
+
+bf::HyperLogLog::HyperLogLog(uint8_t precision)
+    : precision_(std::min<uint8_t>(std::max<uint8_t>(precision, 4), 18)),
+      registers_(std::size_t {1} << precision_, 0) {
+}
+
+/**
+ *  @details The top precision_ bits pick a register; the rank is the
+ *           position of the first set bit among the remaining bits
+ */
+void bf::HyperLogLog::add(uint32_t computer) {
+  uint64_t hash = mix(computer);
+  std::size_t index = hash >> (64 - precision_);
+  uint64_t rest = (hash << precision_) | (uint64_t {1} << (precision_ - 1));
+  uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+  if (rank > registers_[index]) {
+    registers_[index] = rank;
+  }
+}
+
+bool bf::HyperLogLog::merge(const HyperLogLog& other) {
+  if (other.precision_ != precision_) {
+    return false;
+  }
+  for (std::size_t i = 0; i < registers_.size(); ++i) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+  return true;
+}
+
+/**
+ *  @details Raw harmonic-mean estimate, switching to linear counting while
+ *           the estimate is small and some registers are still empty
+ */
+uint64_t bf::HyperLogLog::estimate() const {
+  double m = static_cast<double>(registers_.size());
+  double sum {0};
+  std::size_t zeros {0};
+  for (auto rank : registers_) {
+    sum += std::ldexp(1.0, -rank);
+    zeros += (rank == 0);
+  }
+  double alpha = 0.7213 / (1 + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+  if (estimate <= 2.5 * m && zeros > 0) {
+    estimate = m * std::log(m / zeros);
+  }
+  return static_cast<uint64_t>(estimate + 0.5);
+}
+
+double bf::HyperLogLog::error() const {
+  return 1.04 / std::sqrt(static_cast<double>(registers_.size()));
+}
+
+uint8_t bf::HyperLogLog::precision() const {
+  return precision_;
+}
+
+const std::vector<uint8_t>& bf::HyperLogLog::registers() const {
+  return registers_;
+}
+
+bool bf::HyperLogLog::set_registers(const std::vector<uint8_t>& registers) {
+  if (registers.size() != registers_.size()) {
+    return false;
+  }
+  registers_ = registers;
+  return true;
+}
@@ -0,0 +1,298 @@
+/**
+ *  @file input.cpp
+ *  @brief Line-oriented report input with transparent decompression
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <zlib.h>
+#ifdef BIGFIX_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "bigfix/input.h"
+#include "bigfix/output.h"
+
+bf::Compression bf::detect(const unsigned char* magic, std::size_t length) {
+  if (length >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+    return Compression::kGzip;
+  }
+  if (length >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 &&
+      magic[2] == 0x2f && magic[3] == 0xfd) {
+    return Compression::kZstd;
+  }
+  return Compression::kNone;
+}
+
+/**
+ *  @details Sniff the first four bytes, rewind, and hand compressed files to
+ *           a decompression thread; plain files are read on the caller's thread
+ */
+bf::Input::Input(const std::string& filename, std::size_t depth)
+    : fs_(filename, std::ios::in | std::ios::binary), ring_(depth) {
+  if (!fs_.is_open()) {
+    return;
+  }
+  unsigned char magic[4] {0, 0, 0, 0};
+  fs_.read(reinterpret_cast<char*>(magic), sizeof(magic));
+  compression_ = detect(magic, static_cast<std::size_t>(fs_.gcount()));
+  fs_.clear();
+  fs_.seekg(0);
+  if (compression_ == Compression::kGzip) {
+    worker_ = std::thread(&Input::inflateGzip, this);
+  } else if (compression_ == Compression::kZstd) {
+    worker_ = std::thread(&Input::inflateZstd, this);
+  }
+}
+
+bf::Input::~Input() {
+  ring_.close();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+bool bf::Input::is_open() const {
+  return fs_.is_open();
+}
+
+bf::Compression bf::Input::compression() const {
+  return compression_;
+}
+
+bool bf::Input::failed() const {
+  return failed_;
+}
+
+/**
+ *  @details Lines may straddle chunk boundaries, so keep appending chunks
+ *           until a newline is found or the decompression thread is done
+ */
+bool bf::Input::getline(std::string* line) {
+  if (compression_ == Compression::kNone) {
+    return static_cast<bool>(std::getline(fs_, *line));
+  }
+  line->clear();
+  bool found {false};
+  while (true) {
+    std::size_t nl = chunk_.find('\n', pos_);
+    if (nl != std::string::npos) {
+      line->append(chunk_, pos_, nl - pos_);
+      pos_ = nl + 1;
+      return true;
+    }
+    if (pos_ < chunk_.length()) {
+      line->append(chunk_, pos_, std::string::npos);
+      found = true;
+    }
+    pos_ = 0;
+    if (!ring_.pop(&chunk_)) {
+      chunk_.clear();
+      return found;
+    }
+  }
+}
+
+/**
+ *  @details Inflate with automatic header detection, restarting after each
+ *           member so that concatenated gzip files are read in full
+ */
+void bf::Input::inflateGzip() {
+  z_stream zs {};
+  if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+    failed_ = true;
+    ring_.close();
+    return;
+  }
+  std::vector<char> in(kChunkSize);
+  int status {Z_OK};
+  bool running {true};
+  while (running && fs_) {
+    fs_.read(in.data(), in.size());
+    zs.next_in = reinterpret_cast<Bytef*>(in.data());
+    zs.avail_in = static_cast<uInt>(fs_.gcount());
+    while (running && zs.avail_in > 0) {
+      if (status == Z_STREAM_END) {
+        inflateReset(&zs);
+      }
+      std::string out(kChunkSize, '\0');
+      zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+      zs.avail_out = static_cast<uInt>(out.size());
+      status = inflate(&zs, Z_NO_FLUSH);
+      if (status != Z_OK && status != Z_STREAM_END) {
+        failed_ = true;
+        running = false;
+        break;
+      }
+      out.resize(out.size() - zs.avail_out);
+      if (!out.empty()) {
+        running = ring_.push(std::move(out));
+      }
+    }
+  }
+  // drain output still held by zlib once all input has been consumed
+  while (running && status == Z_OK) {
+    std::string out(kChunkSize, '\0');
+    zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    zs.avail_out = static_cast<uInt>(out.size());
+    status = inflate(&zs, Z_NO_FLUSH);
+    out.resize(out.size() - zs.avail_out);
+    if (out.empty()) {
+      failed_ = (status != Z_STREAM_END);
+      break;
+    }
+    running = ring_.push(std::move(out));
+  }
+  inflateEnd(&zs);
+  ring_.close();
+}
+
+#ifdef BIGFIX_HAVE_ZSTD
+/**
+ *  @details Stream frames through a single decompression context; frames are
+ *           concatenated transparently by ZSTD_decompressStream
+ */
+void bf::Input::inflateZstd() {
+  ZSTD_DStream* zs = ZSTD_createDStream();
+  if (zs == nullptr) {
+    failed_ = true;
+    ring_.close();
+    return;
+  }
+  ZSTD_initDStream(zs);
+  std::vector<char> in(ZSTD_DStreamInSize());
+  std::size_t status {0};
+  bool running {true};
+  while (running && fs_) {
+    fs_.read(in.data(), in.size());
+    ZSTD_inBuffer input {in.data(), static_cast<std::size_t>(fs_.gcount()), 0};
+    while (running && input.pos < input.size) {
+      std::string out(kChunkSize, '\0');
+      ZSTD_outBuffer output {&out[0], out.size(), 0};
+      status = ZSTD_decompressStream(zs, &output, &input);
+      if (ZSTD_isError(status)) {
+        failed_ = true;
+        running = false;
+        break;
+      }
+      out.resize(output.pos);
+      if (!out.empty()) {
+        running = ring_.push(std::move(out));
+      }
+    }
+  }
+  // a non-zero hint means the last frame was not complete
+  if (running && status != 0) {
+    failed_ = true;
+  }
+  ZSTD_freeDStream(zs);
+  ring_.close();
+}
+#else
+/**
+ *  @details Built without libzstd, so zstd input is reported as unreadable
+ */
+void bf::Input::inflateZstd() {
+  message("Error: zstd compressed input is not supported by this build\n");
+  failed_ = true;
+  ring_.close();
+}
+#endif
+
+/**
+ *  @details Grow the output a chunk at a time; like the streaming readers,
+ *           concatenated gzip members and zstd frames are all decoded
+ */
+template <typename String>
+bool bf::decompress(const std::string& in, String* out) {
+  const unsigned char* data = reinterpret_cast<const unsigned char*>(in.data());
+  Compression compression = detect(data, in.length());
+  out->clear();
+  if (compression == Compression::kGzip) {
+    z_stream zs {};
+    if (inflateInit2(&zs, 15 + 32) != Z_OK) {
+      return false;
+    }
+    zs.next_in = const_cast<Bytef*>(data);
+    zs.avail_in = static_cast<uInt>(in.length());
+    int status {Z_OK};
+    while (status == Z_OK || (status == Z_STREAM_END && zs.avail_in > 0)) {
+      if (status == Z_STREAM_END) {
+        inflateReset(&zs);
+      }
+      std::size_t used = out->length();
+      out->resize(used + kChunkSize);
+      zs.next_out = reinterpret_cast<Bytef*>(&(*out)[used]);
+      zs.avail_out = static_cast<uInt>(kChunkSize);
+      status = inflate(&zs, Z_NO_FLUSH);
+      out->resize(out->length() - zs.avail_out);
+    }
+    inflateEnd(&zs);
+    return status == Z_STREAM_END;
+  }
+#ifdef BIGFIX_HAVE_ZSTD
+  if (compression == Compression::kZstd) {
+    ZSTD_DStream* zs = ZSTD_createDStream();
+    if (zs == nullptr) {
+      return false;
+    }
+    ZSTD_initDStream(zs);
+    ZSTD_inBuffer input {in.data(), in.length(), 0};
+    std::size_t status {0};
+    do {
+      std::size_t used = out->length();
+      out->resize(used + kChunkSize);
+      ZSTD_outBuffer output {&(*out)[used], kChunkSize, 0};
+      status = ZSTD_decompressStream(zs, &output, &input);
+      out->resize(used + output.pos);
+      if (input.pos == input.size && output.pos == 0) {
+        // a truncated frame wants more input than there is
+        break;
+      }
+    } while (!ZSTD_isError(status) &&
+             (input.pos < input.size || status != 0));
+    ZSTD_freeDStream(zs);
+    return status == 0;
+  }
+#endif
+  return false;
+}
+
+template bool bf::decompress(const std::string& in, std::string* out);
+template bool bf::decompress(const std::string& in, bf::ArenaString* out);
+
+std::string bf::uncompressedName(const std::string& filename) {
+  const std::string suffixes[] {".gz", ".zst"};
+  for (const auto& suffix : suffixes) {
+    if (filename.length() > suffix.length() &&
+        filename.compare(filename.length() - suffix.length(), suffix.length(),
+                         suffix) == 0) {
+      return filename.substr(0, filename.length() - suffix.length());
+    }
+  }
+  return filename;
+}
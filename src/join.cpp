@@ -0,0 +1,76 @@
+/**
+ *  @file join.cpp
+ *  @brief Join of report counts against the target table
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+#include "bigfix/join.h"
+
+/**
+ *  @details Report names are resolved to interned identifiers with one probe
+ *           each; the rows are then walked in order and matched by
+ *           identifier, so matched and target_only come out in row order
+ *           without sorting. As with GroupTable::find(), only the first row
+ *           holding a name takes its count.
+ */
+void bf::join(const std::map<std::string, uint32_t>& raw,
+              const GroupTable& final, JoinResult* result) {
+  *result = JoinResult();
+  const Interner& names = final.names();
+  std::vector<uint32_t> ids;
+  ids.reserve(raw.size());
+  std::vector<const uint32_t*> count_of(names.size(), nullptr);
+  for (const auto& group : raw) {
+    uint32_t id = names.find(group.first);
+    ids.push_back(id);
+    if (id != Interner::kMissing) {
+      count_of[id] = &group.second;
+    }
+  }
+  std::vector<bool> claimed(names.size(), false);
+  const std::vector<uint32_t>& row_ids = final.name_ids();
+  for (std::size_t row = 0; row < row_ids.size(); ++row) {
+    uint32_t id = row_ids[row];
+    if (count_of[id] == nullptr || claimed[id]) {
+      result->target_only.push_back(row);
+    } else {
+      claimed[id] = true;
+      result->matched.push_back(Match {row, *count_of[id]});
+      result->matched_computers += *count_of[id];
+    }
+  }
+  std::size_t index {0};
+  for (const auto& group : raw) {
+    uint32_t id = ids[index++];
+    if (id == Interner::kMissing || !claimed[id]) {
+      result->report_only.push_back(group);
+      result->report_only_computers += group.second;
+    }
+  }
+}
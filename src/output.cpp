@@ -0,0 +1,228 @@
+/**
+ *  @file output.cpp
+ *  @brief Buffered report output to stdout or to an atomically replaced file
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "bigfix/output.h"
+
+namespace {
+
+/**
+ *  @brief Messages being held for the current thread, or nullptr
+ */
+thread_local std::string* deferred {nullptr};
+
+}  // namespace
+
+/**
+ *  @details mkstemp() creates the temporary file with mode 0600, so it is
+ *           given the permissions a newly created file would normally have
+ */
+bf::Output::Output(const std::string& filename) : filename_(filename) {
+  if (filename_.empty()) {
+    fd_ = STDOUT_FILENO;
+    return;
+  }
+  std::string pattern = filename_ + ".XXXXXX";
+  fd_ = mkstemp(&pattern[0]);
+  if (fd_ < 0) {
+    printf("Error: Could not open file %s\n", filename_.c_str());
+    return;
+  }
+  temporary_ = pattern;
+  mode_t mask = umask(0);
+  umask(mask);
+  fchmod(fd_, 0666 & ~mask);
+}
+
+bf::Output::~Output() {
+  if (filename_.empty()) {
+    flush();
+  } else if (fd_ >= 0 && !committed_) {
+    close(fd_);
+    unlink(temporary_.c_str());
+  }
+}
+
+bool bf::Output::is_open() const {
+  return fd_ >= 0;
+}
+
+void bf::Output::write(const char* data, std::size_t length) {
+  while (length > 0) {
+    if (used_ == 0 || blocks_[used_ - 1].length() == kOutputBlock) {
+      if (used_ == kOutputBlocks) {
+        flush();
+      }
+      if (used_ == blocks_.size()) {
+        blocks_.emplace_back();
+        blocks_.back().reserve(kOutputBlock);
+      }
+      ++used_;
+    }
+    std::string* block = &blocks_[used_ - 1];
+    std::size_t count = std::min(length, kOutputBlock - block->length());
+    block->append(data, count);
+    data += count;
+    length -= count;
+  }
+}
+
+void bf::Output::write(const std::string& text) {
+  write(text.data(), text.length());
+}
+
+/**
+ *  @details Short text is formatted on the stack; longer text is formatted
+ *           again into a buffer of the length the first attempt reported
+ */
+void bf::Output::print(const char* format, ...) {
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length < 0) {
+    return;
+  }
+  if (static_cast<std::size_t>(length) < sizeof(text)) {
+    write(text, length);
+    return;
+  }
+  std::string long_text(length + 1, '\0');
+  va_start(args, format);
+  vsnprintf(&long_text[0], long_text.size(), format, args);
+  va_end(args);
+  write(long_text.data(), length);
+}
+
+/**
+ *  @details Partial writes advance through the gathered blocks until all of
+ *           them have been written; interrupted calls are retried
+ */
+bool bf::Output::flush() {
+  if (filename_.empty()) {
+    fflush(stdout);
+  }
+  if (fd_ < 0 || failed_) {
+    used_ = 0;
+    return false;
+  }
+  std::vector<struct iovec> pending;
+  for (std::size_t i = 0; i < used_; ++i) {
+    if (!blocks_[i].empty()) {
+      pending.push_back({&blocks_[i][0], blocks_[i].length()});
+    }
+  }
+  std::size_t first {0};
+  while (first < pending.size()) {
+    ssize_t n = writev(fd_, &pending[first],
+                       static_cast<int>(pending.size() - first));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      failed_ = true;
+      break;
+    }
+    std::size_t done = static_cast<std::size_t>(n);
+    while (first < pending.size() && done >= pending[first].iov_len) {
+      done -= pending[first].iov_len;
+      ++first;
+    }
+    if (first < pending.size()) {
+      pending[first].iov_base =
+          static_cast<char*>(pending[first].iov_base) + done;
+      pending[first].iov_len -= done;
+    }
+  }
+  for (std::size_t i = 0; i < used_; ++i) {
+    blocks_[i].clear();
+  }
+  used_ = 0;
+  return !failed_;
+}
+
+bool bf::Output::commit() {
+  bool ok = flush();
+  if (filename_.empty() || fd_ < 0 || committed_) {
+    return ok;
+  }
+  committed_ = true;
+  ok = close(fd_) == 0 && ok;
+  if (!ok || rename(temporary_.c_str(), filename_.c_str()) != 0) {
+    printf("Error: Could not write file %s\n", filename_.c_str());
+    unlink(temporary_.c_str());
+    return false;
+  }
+  return true;
+}
+
+/**
+ *  @details Held messages are formatted the same way as Output::print()
+ */
+void bf::message(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  if (deferred == nullptr) {
+    vprintf(format, args);
+    va_end(args);
+    return;
+  }
+  char text[256];
+  int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length < 0) {
+    return;
+  }
+  if (static_cast<std::size_t>(length) < sizeof(text)) {
+    deferred->append(text, length);
+    return;
+  }
+  std::string long_text(length + 1, '\0');
+  va_start(args, format);
+  vsnprintf(&long_text[0], long_text.size(), format, args);
+  va_end(args);
+  deferred->append(long_text.data(), length);
+}
+
+bf::DeferMessages::DeferMessages(std::string* messages) : previous_(deferred) {
+  deferred = messages;
+}
+
+bf::DeferMessages::~DeferMessages() {
+  deferred = previous_;
+}
@@ -0,0 +1,282 @@
+/**
+ *  @file partial.cpp
+ *  @brief Serialized partial aggregates for sharded ingestion
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>  // NOLINT
+#include <map>
+#include <string>
+#include <vector>
+#include "bigfix/partial.h"
+
+namespace {
+
+/** record holding a group's summed computer count */
+const char kCountRecord {'C'};
+
+/** record holding a group's exact membership */
+const char kBitmapRecord {'B'};
+
+/** record holding a group's HyperLogLog registers */
+const char kSketchRecord {'S'};
+
+/** record marking the end of the file */
+const char kEndRecord {'E'};
+
+/** header flag set when endpoint groups are sketched */
+const uint8_t kApproximateFlag {1};
+
+/**
+ *  @brief Append an unsigned integer using 7 bits per byte
+ *  @param value value to encode
+ *  @param out buffer to append to
+ */
+void putVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+/**
+ *  @brief Append a length-prefixed string
+ *  @param text string to encode
+ *  @param out buffer to append to
+ */
+void putString(const std::string& text, std::string* out) {
+  putVarint(text.length(), out);
+  out->append(text);
+}
+
+/**
+ *  @brief Sequential decoder over a partial aggregate file
+ *  @details Any read past the end of the file or any malformed value clears
+ *           ok, after which every read returns zero or empty values
+ */
+struct Reader {
+  std::ifstream fs;
+  bool ok;
+
+  explicit Reader(const std::string& filename)
+      : fs(filename, std::ios::in | std::ios::binary), ok(fs.is_open()) {
+  }
+
+  uint8_t byte() {
+    char c {0};
+    if (ok && !fs.get(c)) {
+      ok = false;
+    }
+    return ok ? static_cast<uint8_t>(c) : 0;
+  }
+
+  uint64_t varint() {
+    uint64_t value {0};
+    for (int shift = 0; ok && shift < 64; shift += 7) {
+      uint8_t b = byte();
+      value |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if ((b & 0x80) == 0) {
+        return value;
+      }
+    }
+    ok = false;
+    return 0;
+  }
+
+  std::string bytes(uint64_t length) {
+    std::string text;
+    // refuse lengths that cannot be valid before allocating for them
+    if (ok && length > (uint64_t {1} << 24)) {
+      ok = false;
+    }
+    if (ok) {
+      text.resize(static_cast<std::size_t>(length));
+      ok = static_cast<bool>(fs.read(&text[0], text.length()));
+    }
+    return ok ? text : std::string();
+  }
+
+  std::string string() {
+    return bytes(varint());
+  }
+};
+
+}  // namespace
+
+bf::Partial::Partial(bool approximate) : endpoints_(approximate) {
+}
+
+void bf::Partial::add(const std::string& date,
+                      const std::map<std::string, uint32_t>& raw) {
+  if (date > date_) {
+    date_ = date;
+  }
+  for (const auto& group : raw) {
+    raw_[group.first] += group.second;
+  }
+}
+
+void bf::Partial::add(const std::string& date, const EndpointSet& endpoints) {
+  if (date > date_) {
+    date_ = date;
+  }
+  endpoints_.merge(endpoints);
+}
+
+/**
+ *  @details Records are applied as they are decoded, so merging a file costs
+ *           memory for one group rather than for the whole partial
+ */
+bool bf::Partial::load(const std::string& filename) {
+  Reader in(filename);
+  if (!in.ok) {
+    printf("Error: Could not open file %s\n", filename.c_str());
+    return false;
+  }
+  std::string magic = in.bytes(sizeof(kPartialMagic) - 1);
+  if (magic != kPartialMagic || in.byte() != kPartialVersion) {
+    printf("Error: File %s is not a partial aggregate\n", filename.c_str());
+    return false;
+  }
+  uint8_t flags = in.byte();
+  uint8_t precision = in.byte();
+  std::string date = in.string();
+  if (date > date_) {
+    date_ = date;
+  }
+  if ((flags & kApproximateFlag) != 0) {
+    endpoints_.sketch();
+  }
+  std::vector<uint32_t> computers;
+  while (in.ok) {
+    char tag = static_cast<char>(in.byte());
+    if (tag == kEndRecord) {
+      return true;
+    }
+    std::string name = in.string();
+    if (tag == kCountRecord) {
+      raw_[name] += static_cast<uint32_t>(in.varint());
+    } else if (tag == kBitmapRecord) {
+      // computer IDs are stored in ascending order as deltas
+      Bitmap members;
+      uint64_t count = in.varint();
+      uint64_t computer {0};
+      for (uint64_t i = 0; in.ok && i < count; ++i) {
+        computer += in.varint();
+        in.ok = in.ok && computer <= UINT32_MAX;
+        members.add(static_cast<uint32_t>(computer));
+      }
+      if (in.ok) {
+        endpoints_.merge(name, members);
+      }
+    } else if (tag == kSketchRecord) {
+      HyperLogLog sketch(precision);
+      std::string registers = in.bytes(sketch.registers().size());
+      in.ok = in.ok && sketch.set_registers(
+          std::vector<uint8_t>(registers.begin(), registers.end())) &&
+          endpoints_.merge(name, sketch);
+    } else {
+      in.ok = false;
+    }
+  }
+  printf("Error: File %s is truncated or corrupt\n", filename.c_str());
+  return false;
+}
+
+/**
+ *  @details Each group is encoded and written separately so a large exact
+ *           partial is never held in memory twice. Groups are written in name
+ *           order, since their identifiers depend on which worker found them
+ *           first, so the file is the same for any number of threads
+ */
+bool bf::Partial::save(const std::string& filename) const {
+  std::ofstream fs(filename, std::ios::out | std::ios::binary |
+                   std::ios::trunc);
+  if (!fs.is_open()) {
+    printf("Error: Could not open file %s\n", filename.c_str());
+    return false;
+  }
+  std::string out(kPartialMagic, sizeof(kPartialMagic) - 1);
+  out.push_back(static_cast<char>(kPartialVersion));
+  out.push_back(static_cast<char>(endpoints_.approximate() ? kApproximateFlag
+                                                           : 0));
+  out.push_back(static_cast<char>(HyperLogLog().precision()));
+  putString(date_, &out);
+  for (const auto& group : raw_) {
+    out.push_back(kCountRecord);
+    putString(group.first, &out);
+    putVarint(group.second, &out);
+  }
+  fs.write(out.data(), out.length());
+  std::vector<uint32_t> ids(endpoints_.size()), computers;
+  for (uint32_t id = 0; id < ids.size(); ++id) {
+    ids[id] = id;
+  }
+  std::sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b) {
+    return endpoints_.name(a) < endpoints_.name(b);
+  });
+  for (auto id : ids) {
+    out.clear();
+    putString(endpoints_.name(id), &out);
+    if (endpoints_.approximate()) {
+      const std::vector<uint8_t>& registers = endpoints_.sketch(id).registers();
+      out.insert(out.begin(), kSketchRecord);
+      out.append(registers.begin(), registers.end());
+    } else {
+      endpoints_.members(id).values(&computers);
+      out.insert(out.begin(), kBitmapRecord);
+      putVarint(computers.size(), &out);
+      uint32_t previous {0};
+      for (auto computer : computers) {
+        putVarint(computer - previous, &out);
+        previous = computer;
+      }
+    }
+    fs.write(out.data(), out.length());
+  }
+  fs.put(kEndRecord);
+  fs.close();
+  if (!fs) {
+    printf("Error: Could not write file %s\n", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+const std::string& bf::Partial::date() const {
+  return date_;
+}
+
+const std::map<std::string, uint32_t>& bf::Partial::raw() const {
+  return raw_;
+}
+
+const bf::EndpointSet& bf::Partial::endpoints() const {
+  return endpoints_;
+}
@@ -0,0 +1,269 @@
+/**
+ *  @file readengine.cpp
+ *  @brief Asynchronous whole-file reader for batch report ingestion
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef BIGFIX_HAVE_LIBURING
+#include <liburing.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "bigfix/besapi.h"
+#include "bigfix/bigfixstats.h"
+#include "bigfix/readengine.h"
+#include "bigfix/ringbuffer.h"
+
+namespace {
+
+/**
+ *  @brief A finished read travelling from a worker to the calling thread
+ */
+struct Completion {
+  std::size_t index {0};
+  std::string buffer;
+  bool ok {false};
+};
+
+/**
+ *  @brief Read an entire file with pread(), hinting sequential access
+ *  @param filename file to read
+ *  @param buffer receives the file contents
+ *  @retval bool false if the file could not be opened or read
+ */
+bool readFile(const std::string& filename, std::string* buffer) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd, 0, st.st_size, POSIX_FADV_SEQUENTIAL);
+#endif
+  buffer->resize(static_cast<std::size_t>(st.st_size));
+  std::size_t done {0};
+  while (done < buffer->size()) {
+    ssize_t n = pread(fd, &(*buffer)[done], buffer->size() - done, done);
+    if (n < 0) {
+      close(fd);
+      return false;
+    }
+    if (n == 0) {
+      // file shrank after fstat
+      buffer->resize(done);
+      break;
+    }
+    done += static_cast<std::size_t>(n);
+  }
+  close(fd);
+  return true;
+}
+
+}  // namespace
+
+bf::ReadEngine::ReadEngine(std::size_t depth) : depth_(depth > 0 ? depth : 1) {
+}
+
+const char* bf::ReadEngine::backend() const {
+#ifdef BIGFIX_HAVE_LIBURING
+  return "io_uring";
+#else
+  return "pread";
+#endif
+}
+
+void bf::ReadEngine::run(const std::vector<std::string>& files,
+                         Handler handler) {
+#ifdef BIGFIX_HAVE_LIBURING
+  if (runUring(files, handler)) {
+    return;
+  }
+#endif
+  runThreads(files, handler);
+}
+
+/**
+ *  @details Each worker claims the next unread file, so at most depth_ reads
+ *           are outstanding; finished buffers queue up in a ring buffer of the
+ *           same depth until the calling thread has parsed them
+ */
+void bf::ReadEngine::runThreads(const std::vector<std::string>& files,
+                                Handler handler) {
+  std::atomic<std::size_t> next {0};
+  RingBuffer<Completion> done(depth_);
+  std::vector<std::thread> workers;
+  std::size_t count = std::min(depth_, files.size());
+  for (std::size_t i = 0; i < count; ++i) {
+    workers.emplace_back([&files, &next, &done] {
+      std::size_t index;
+      while ((index = next++) < files.size()) {
+        Completion c;
+        c.index = index;
+        c.ok = readFile(files[index], &c.buffer);
+        done.push(std::move(c));
+      }
+    });
+  }
+  Completion c;
+  for (std::size_t i = 0; i < files.size() && done.pop(&c); ++i) {
+    handler(c.index, &c.buffer, c.ok);
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+#ifdef BIGFIX_HAVE_LIBURING
+/**
+ *  @details Files are opened and sized synchronously, then read with one
+ *           request per file; short reads are resubmitted for the remainder
+ */
+bool bf::ReadEngine::runUring(const std::vector<std::string>& files,
+                              Handler handler) {
+  struct io_uring ring;
+  if (io_uring_queue_init(static_cast<unsigned>(depth_), &ring, 0) < 0) {
+    return false;
+  }
+  struct Pending {
+    std::size_t index;
+    int fd;
+    std::size_t done;
+    std::string buffer;
+  };
+  std::vector<Pending> slots(depth_);
+  std::vector<std::size_t> free_slots;
+  for (std::size_t i = depth_; i > 0; --i) {
+    free_slots.push_back(i - 1);
+  }
+  auto submit = [&ring](Pending* p, std::size_t slot) {
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+    io_uring_prep_read(sqe, p->fd, &p->buffer[p->done],
+                       static_cast<unsigned>(p->buffer.size() - p->done),
+                       p->done);
+    io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(slot));
+  };
+  std::size_t next {0}, inflight {0};
+  while (next < files.size() || inflight > 0) {
+    // top up the submission queue
+    while (next < files.size() && !free_slots.empty()) {
+      std::size_t index = next++;
+      int fd = open(files[index].c_str(), O_RDONLY);
+      struct stat st;
+      if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) {
+          close(fd);
+        }
+        std::string empty;
+        handler(index, &empty, false);
+        continue;
+      }
+      if (st.st_size == 0) {
+        close(fd);
+        std::string empty;
+        handler(index, &empty, true);
+        continue;
+      }
+      std::size_t slot = free_slots.back();
+      free_slots.pop_back();
+      Pending& p = slots[slot];
+      p.index = index;
+      p.fd = fd;
+      p.done = 0;
+      p.buffer.assign(static_cast<std::size_t>(st.st_size), '\0');
+      submit(&p, slot);
+      ++inflight;
+    }
+    if (inflight == 0) {
+      // every remaining file failed to open or was empty
+      continue;
+    }
+    io_uring_submit(&ring);
+    // reap one completion, then any others that are already available
+    struct io_uring_cqe* cqe;
+    if (io_uring_wait_cqe(&ring, &cqe) < 0) {
+      break;
+    }
+    do {
+      std::size_t slot =
+          reinterpret_cast<std::size_t>(io_uring_cqe_get_data(cqe));
+      Pending& p = slots[slot];
+      int res = cqe->res;
+      io_uring_cqe_seen(&ring, cqe);
+      if (res > 0 && p.done + res < p.buffer.size()) {
+        p.done += static_cast<std::size_t>(res);
+        submit(&p, slot);
+        continue;
+      }
+      if (res >= 0) {
+        p.buffer.resize(p.done + static_cast<std::size_t>(res));
+      }
+      close(p.fd);
+      handler(p.index, &p.buffer, res >= 0);
+      free_slots.push_back(slot);
+      --inflight;
+    } while (io_uring_peek_cqe(&ring, &cqe) == 0);
+  }
+  io_uring_queue_exit(&ring);
+  return true;
+}
+#endif
+
+std::vector<std::string> bf::listReports(const std::string& directory) {
+  std::vector<std::string> reports;
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    printf("Error: Could not open directory %s\n", directory.c_str());
+    return reports;
+  }
+  const std::string suffixes[] {kExt, kExt + ".gz", kExt + ".zst",
+                                kXmlExt, kXmlExt + ".gz", kXmlExt + ".zst",
+                                kCsvExt, kCsvExt + ".gz", kCsvExt + ".zst"};
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    for (const auto& suffix : suffixes) {
+      if (name.length() > suffix.length() &&
+          name.compare(name.length() - suffix.length(), suffix.length(),
+                       suffix) == 0) {
+        reports.push_back(directory + "/" + name);
+        break;
+      }
+    }
+  }
+  closedir(dir);
+  std::sort(reports.begin(), reports.end());
+  return reports;
+}
@@ -0,0 +1,269 @@
+/**
+ *  @file spill.cpp
+ *  @brief External sort of 64-bit keys within a memory budget
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bigfix/bigfixstats.h"
+#include "bigfix/output.h"
+#include "bigfix/spill.h"
+
+namespace {
+
+/**
+ *  @brief Create an anonymous temporary file for a run
+ *  @retval FILE* open file, already unlinked, or nullptr on failure
+ */
+FILE* createRun() {
+  const char* directory = getenv("TMPDIR");
+  std::string pattern = directory != nullptr && *directory != '\0'
+                            ? directory : "/tmp";
+  pattern += "/bfstats.XXXXXX";
+  int fd = mkstemp(&pattern[0]);
+  if (fd < 0) {
+    return nullptr;
+  }
+  unlink(pattern.c_str());
+  FILE* file = fdopen(fd, "w+b");
+  if (file == nullptr) {
+    close(fd);
+  }
+  return file;
+}
+
+/**
+ *  @brief Reads one sorted run back a block at a time
+ */
+struct RunReader {
+  FILE* file {nullptr};
+  std::vector<uint64_t> block;
+  std::size_t pos {0};
+
+  /**
+   *  @brief Make the next key available at block[pos]
+   *  @retval bool false once the run is exhausted
+   */
+  bool fill() {
+    if (pos < block.size()) {
+      return true;
+    }
+    block.resize(block.capacity());
+    block.resize(fread(block.data(), sizeof(uint64_t), block.size(), file));
+    pos = 0;
+    return !block.empty();
+  }
+};
+
+/**
+ *  @brief Visit the keys of several sorted runs and a sorted array in order
+ *  @details A min-heap holds the next key of every run plus the next key in
+ *           memory, which takes the last slot; each key visited is replaced
+ *           by the next one from the same source
+ *  @param runs sorted runs, read from the start
+ *  @param keys sorted keys still in memory
+ *  @param count number of keys
+ *  @param block number of keys read from each run at a time
+ *  @param visit called once per key, duplicates included
+ *  @retval bool false if a run could not be read
+ */
+bool mergeRuns(const std::vector<FILE*>& runs, const uint64_t* keys,
+               std::size_t count, std::size_t block,
+               const std::function<void(uint64_t)>& visit) {
+  std::vector<RunReader> readers(runs.size());
+  typedef std::pair<uint64_t, std::size_t> Head;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+  for (std::size_t i = 0; i < runs.size(); ++i) {
+    readers[i].file = runs[i];
+    readers[i].block.reserve(block);
+    rewind(runs[i]);
+    if (readers[i].fill()) {
+      heads.emplace(readers[i].block[0], i);
+    }
+  }
+  std::size_t memory = runs.size(), next {0};
+  if (next < count) {
+    heads.emplace(keys[next++], memory);
+  }
+  while (!heads.empty()) {
+    Head head = heads.top();
+    heads.pop();
+    visit(head.first);
+    if (head.second == memory) {
+      if (next < count) {
+        heads.emplace(keys[next++], memory);
+      }
+      continue;
+    }
+    RunReader& reader = readers[head.second];
+    ++reader.pos;
+    if (reader.fill()) {
+      heads.emplace(reader.block[reader.pos], head.second);
+    }
+  }
+  for (auto run : runs) {
+    if (ferror(run)) {
+      bf::message("Error: Could not read temporary file for --max-memory\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bf::ExternalSort::ExternalSort(std::size_t budget) : budget_(budget) {
+}
+
+void bf::ExternalSort::spill() {
+  std::sort(keys_.begin(), keys_.end());
+  FILE* file = createRun();
+  if (file == nullptr ||
+      fwrite(keys_.data(), sizeof(uint64_t), keys_.size(), file) !=
+          keys_.size() ||
+      fflush(file) != 0) {
+    if (!failed_) {
+      message("Error: Could not write temporary file for --max-memory\n");
+    }
+    failed_ = true;
+    if (file != nullptr) {
+      fclose(file);
+    }
+  } else {
+    runs_.emplace_back(file, fclose);
+    levels_.push_back(0);
+    compact();
+  }
+  keys_.clear();
+}
+
+/**
+ *  @details Like a binary counter in base kMergeFanIn: a new run may complete
+ *           a set at level 0, whose merged run may complete a set at level 1
+ */
+void bf::ExternalSort::compact() {
+  while (!failed_ && runs_.size() >= kMergeFanIn &&
+         levels_[levels_.size() - kMergeFanIn] == levels_.back()) {
+    std::size_t first = runs_.size() - kMergeFanIn;
+    std::vector<FILE*> runs;
+    for (std::size_t i = first; i < runs_.size(); ++i) {
+      runs.push_back(runs_[i].get());
+    }
+    FILE* file = createRun();
+    bool written = file != nullptr;
+    bool read = mergeRuns(runs, nullptr, 0, block(),
+                          [file, &written](uint64_t key) {
+      written = written && fwrite(&key, sizeof(key), 1, file) == 1;
+    });
+    written = written && fflush(file) == 0;
+    if (!written || !read) {
+      if (!written) {
+        message("Error: Could not write temporary file for --max-memory\n");
+      }
+      failed_ = true;
+      if (file != nullptr) {
+        fclose(file);
+      }
+      return;
+    }
+    unsigned level = levels_.back() + 1;
+    runs_.resize(first);
+    levels_.resize(first);
+    runs_.emplace_back(file, fclose);
+    levels_.push_back(level);
+  }
+}
+
+/**
+ *  @details Merging reads a block from every open run at once, so the blocks
+ *           share the budget; stdio still buffers each run on its own
+ */
+std::size_t bf::ExternalSort::block() const {
+  std::size_t keys = budget_ / sizeof(uint64_t) / (runs_.size() + 1);
+  return std::max<std::size_t>(std::min(keys, kMergeBlock), 1);
+}
+
+bool bf::ExternalSort::merge(const std::function<void(uint64_t)>& visit) {
+  std::sort(keys_.begin(), keys_.end());
+  std::vector<FILE*> runs;
+  for (const auto& run : runs_) {
+    runs.push_back(run.get());
+  }
+  bool ok = mergeRuns(runs, keys_.data(), keys_.size(), block(), visit) &&
+            !failed_;
+  std::vector<uint64_t>().swap(keys_);
+  runs_.clear();
+  levels_.clear();
+  failed_ = false;
+  return ok;
+}
+
+std::size_t bf::ExternalSort::budget() const {
+  return budget_;
+}
+
+std::size_t bf::ExternalSort::runs() const {
+  return runs_.size();
+}
+
+/**
+ *  @details The digits go through parseNumber, so signs, blanks and values
+ *           out of range are refused, and the unit is applied only if the
+ *           result still fits
+ */
+bool bf::parseSize(const std::string& text, std::size_t* bytes) {
+  std::string digits = text;
+  unsigned shift {0};
+  if (!digits.empty()) {
+    switch (toupper(static_cast<unsigned char>(digits.back()))) {
+      case 'K': shift = 10; break;
+      case 'M': shift = 20; break;
+      case 'G': shift = 30; break;
+      default: break;
+    }
+  }
+  if (shift > 0) {
+    digits.pop_back();
+  }
+  std::size_t value {0};
+  if (!parseNumber(digits, &value) ||
+      value > (std::numeric_limits<std::size_t>::max() >> shift)) {
+    return false;
+  }
+  *bytes = value << shift;
+  return true;
+}
@@ -0,0 +1,174 @@
+/**
+ *  @file targets.cpp
+ *  @brief Parser for deployment target files
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "bigfix/bigfixstats.h"
+#include "bigfix/targets.h"
+
+namespace {
+
+/**
+ *  @brief Whether a character is a blank that may surround a field
+ *  @param c character to test
+ *  @retval bool true for spaces and tabs
+ */
+inline bool blank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+/**
+ *  @brief Print a parse error for one line of a target file
+ *  @param filename name of the file
+ *  @param line line number, starting at 1
+ *  @param message description of the problem
+ *  @param text offending text
+ *  @param length length of the offending text
+ */
+void report(const std::string& filename, std::size_t line,
+            const char* message, const char* text, std::size_t length) {
+  printf("Error: %s:%zu: %s \"%.*s\"\n", filename.c_str(), line, message,
+         static_cast<int>(length), text);
+}
+
+}  // namespace
+
+/**
+ *  @details One pass over the buffer: lines are found with memchr and each
+ *           field is trimmed and converted in place, so the only copy made is
+ *           the group name handed to the table
+ */
+bool bf::parseTargets(const char* data, std::size_t length,
+                      const std::string& filename, GroupTable* final) {
+  bool ok {true}, first {true};
+  std::size_t number {0};
+  std::string name;
+  const char* end = data + length;
+  for (const char* line = data; line < end; ) {
+    const char* nl = static_cast<const char*>(memchr(line, '\n', end - line));
+    const char* last = nl != nullptr ? nl : end;
+    const char* next = nl != nullptr ? nl + 1 : end;
+    ++number;
+    if (last > line && last[-1] == '\r') {
+      --last;
+    }
+    const char* p = line;
+    while (p < last && blank(*p)) {
+      ++p;
+    }
+    if (p == last || *p == kComment) {
+      line = next;
+      continue;
+    }
+    // computer group, either quoted or up to the delimiter
+    name.clear();
+    bool quoted = (*p == '"');
+    if (quoted) {
+      for (++p; p < last; ++p) {
+        if (*p == '"') {
+          if (p + 1 < last && p[1] == '"') {
+            ++p;
+          } else {
+            break;
+          }
+        }
+        name.push_back(*p);
+      }
+      if (p == last) {
+        report(filename, number, "unterminated quote in", line, last - line);
+        ok = false;
+        line = next;
+        continue;
+      }
+      ++p;
+      while (p < last && blank(*p)) {
+        ++p;
+      }
+    } else {
+      const char* delim = static_cast<const char*>(
+          memchr(p, kDelim[0], last - p));
+      const char* stop = delim != nullptr ? delim : last;
+      while (stop > p && blank(stop[-1])) {
+        --stop;
+      }
+      name.assign(p, stop - p);
+      p = delim != nullptr ? delim : last;
+    }
+    if (p == last || *p != kDelim[0]) {
+      report(filename, number, "expected group,target but found", line,
+             last - line);
+      ok = false;
+      line = next;
+      continue;
+    }
+    // target count, digits only
+    ++p;
+    while (p < last && blank(*p)) {
+      ++p;
+    }
+    const char* stop = last;
+    while (stop > p && blank(stop[-1])) {
+      --stop;
+    }
+    uint64_t target {0};
+    const char* digit = p;
+    for (; digit < stop && *digit >= '0' && *digit <= '9'; ++digit) {
+      target = target * 10 + static_cast<uint64_t>(*digit - '0');
+      if (target > UINT32_MAX) {
+        break;
+      }
+    }
+    bool numeric = (digit == stop && stop > p);
+    if (!numeric && first) {
+      // header line such as "group,target"
+      first = false;
+      line = next;
+      continue;
+    }
+    first = false;
+    if (!numeric) {
+      report(filename, number, "invalid target", p, stop - p);
+      ok = false;
+    } else if (name.empty()) {
+      report(filename, number, "missing computer group in", line,
+             last - line);
+      ok = false;
+    } else if (final->find(name) != kNoRow) {
+      report(filename, number, "duplicate computer group", name.data(),
+             name.length());
+      ok = false;
+    } else {
+      final->add(name).set_target(static_cast<uint32_t>(target));
+    }
+    line = next;
+  }
+  return ok;
+}
@@ -0,0 +1,267 @@
+/**
+ *  @file threadpool.cpp
+ *  @brief Work-stealing thread pool shared by all parallel stages
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+#include "bigfix/threadpool.h"
+
+namespace {
+
+/**
+ *  @brief Pool whose worker is the calling thread, if any
+ */
+thread_local const bf::ThreadPool* current_pool {nullptr};
+
+/**
+ *  @brief Index of the calling thread within current_pool
+ */
+thread_local std::size_t current_worker {0};
+
+/**
+ *  @brief Seconds elapsed since a point in time
+ *  @param start earlier point in time
+ *  @retval double elapsed seconds
+ */
+double since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+}  // namespace
+
+std::size_t bf::defaultThreads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+bf::ThreadPool::ThreadPool(std::size_t threads, bool affinity) {
+  if (threads == 0) {
+    threads = defaultThreads();
+  }
+  for (std::size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back(new Worker);
+  }
+  pinned_ = affinity;
+  for (std::size_t i = 0; i < threads; ++i) {
+    workers_[i]->thread = std::thread(&ThreadPool::loop, this, i);
+    if (affinity && !pin(&workers_[i]->thread, i)) {
+      pinned_ = false;
+    }
+  }
+}
+
+bf::ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+std::size_t bf::ThreadPool::size() const {
+  return workers_.size();
+}
+
+bool bf::ThreadPool::pinned() const {
+  return pinned_;
+}
+
+/**
+ *  @details The CPU is picked from the affinity mask of the calling thread,
+ *           so a pool started under taskset stays within the given CPUs
+ */
+bool bf::ThreadPool::pin(std::thread* thread, std::size_t index) {
+#ifdef __linux__
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return false;
+  }
+  int count = CPU_COUNT(&allowed);
+  if (count == 0) {
+    return false;
+  }
+  int skip = static_cast<int>(index % count);
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed) && skip-- == 0) {
+      cpu_set_t one;
+      CPU_ZERO(&one);
+      CPU_SET(cpu, &one);
+      return pthread_setaffinity_np(thread->native_handle(), sizeof(one),
+                                    &one) == 0;
+    }
+  }
+  return false;
+#else
+  return false;
+#endif
+}
+
+/**
+ *  @details A task submitted by a task stays on its worker, where it is
+ *           likely to find its input still in cache
+ */
+void bf::ThreadPool::submit(Task task) {
+  ++pending_;
+  std::size_t index = current_pool == this ? current_worker
+                                           : next_++ % workers_.size();
+  Worker& worker = *workers_[index];
+  {
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+    ++queued_;
+    worker.stats.max_depth = std::max(worker.stats.max_depth,
+                                      worker.tasks.size());
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  wake_.notify_one();
+}
+
+void bf::ThreadPool::wait(std::size_t limit) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this, limit] { return pending_ <= limit; });
+}
+
+void bf::ThreadPool::run(std::size_t count,
+                         const std::function<void(std::size_t index,
+                                                  std::size_t worker)>& body) {
+  for (std::size_t i = 0; i < count; ++i) {
+    submit([&body, i](std::size_t worker) { body(i, worker); });
+  }
+  wait();
+}
+
+std::vector<bf::WorkerStats> bf::ThreadPool::stats() {
+  std::vector<WorkerStats> stats;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& worker : workers_) {
+    std::lock_guard<std::mutex> worker_lock(worker->mutex);
+    stats.push_back(worker->stats);
+    if (worker->asleep) {
+      stats.back().idle += since(worker->since);
+    }
+  }
+  return stats;
+}
+
+void bf::ThreadPool::reset_stats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& worker : workers_) {
+    std::lock_guard<std::mutex> worker_lock(worker->mutex);
+    worker->stats = WorkerStats();
+    if (worker->asleep) {
+      worker->since = std::chrono::steady_clock::now();
+    }
+  }
+}
+
+/**
+ *  @details Own tasks are taken newest first and stolen tasks oldest first,
+ *           so owner and thief work from opposite ends of a queue
+ */
+bool bf::ThreadPool::take(std::size_t index, Task* task) {
+  Worker& self = *workers_[index];
+  {
+    std::lock_guard<std::mutex> lock(self.mutex);
+    if (!self.tasks.empty()) {
+      *task = std::move(self.tasks.back());
+      self.tasks.pop_back();
+      --queued_;
+      return true;
+    }
+  }
+  for (std::size_t i = 1; i < workers_.size(); ++i) {
+    Worker& victim = *workers_[(index + i) % workers_.size()];
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (victim.tasks.empty()) {
+        continue;
+      }
+      *task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      --queued_;
+    }
+    std::lock_guard<std::mutex> lock(self.mutex);
+    ++self.stats.steals;
+    return true;
+  }
+  return false;
+}
+
+/**
+ *  @details Workers sleep only once every queue is empty and keep draining
+ *           queued tasks after the pool is told to stop
+ */
+void bf::ThreadPool::loop(std::size_t index) {
+  current_pool = this;
+  current_worker = index;
+  Worker& self = *workers_[index];
+  Task task;
+  while (true) {
+    if (take(index, &task)) {
+      auto start = std::chrono::steady_clock::now();
+      task(index);
+      task = nullptr;
+      double busy = since(start);
+      {
+        std::lock_guard<std::mutex> lock(self.mutex);
+        ++self.stats.tasks;
+        self.stats.busy += busy;
+      }
+      --pending_;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+      }
+      done_.notify_all();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stop_ && queued_ == 0) {
+      return;
+    }
+    self.asleep = true;
+    self.since = std::chrono::steady_clock::now();
+    wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+    self.asleep = false;
+    std::lock_guard<std::mutex> worker_lock(self.mutex);
+    self.stats.idle += since(self.since);
+  }
+}
@@ -0,0 +1,133 @@
+/**
+ *  @file tokenizer.cpp
+ *  @brief Zero-copy helpers for scanning report table rows
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bigfix/tokenizer.h"
+
+constexpr char bf::HtmlSchema::kRecord[];
+constexpr char bf::HtmlSchema::kStart[];
+constexpr char bf::HtmlSchema::kEnd[];
+constexpr char bf::UpperHtmlSchema::kRecord[];
+constexpr char bf::UpperHtmlSchema::kStart[];
+constexpr char bf::UpperHtmlSchema::kEnd[];
+constexpr char bf::HeaderSchema::kRecord[];
+constexpr char bf::HeaderSchema::kStart[];
+constexpr char bf::HeaderSchema::kEnd[];
+constexpr char bf::UpperHeaderSchema::kRecord[];
+constexpr char bf::UpperHeaderSchema::kStart[];
+constexpr char bf::UpperHeaderSchema::kEnd[];
+
+bool bf::isUpperCase(const char* data, std::size_t length) {
+  return findTag(data, length, 0, UpperHtmlSchema::kRecord) <
+         findTag(data, length, 0, HtmlSchema::kRecord);
+}
+
+bool bf::parseNumber(const char* data, std::size_t length, uint32_t* value) {
+  std::size_t i {0};
+  while (i < length && isspace(static_cast<unsigned char>(data[i]))) {
+    ++i;
+  }
+  std::size_t first = i;
+  uint64_t number {0};
+  *value = 0;
+  for (; i < length && data[i] >= '0' && data[i] <= '9'; ++i) {
+    number = number * 10 + static_cast<uint64_t>(data[i] - '0');
+    if (number > UINT32_MAX) {
+      return false;
+    }
+  }
+  *value = static_cast<uint32_t>(number);
+  return i > first;
+}
+
+template <typename Schema>
+void bf::splitCells(const char* line, std::size_t length,
+                    std::vector<Cell>* cells) {
+  cells->clear();
+  std::size_t start = findTag(line, length, 0, Schema::kStart);
+  while (start != std::string::npos) {
+    start += sizeof(Schema::kStart) - 1;
+    std::size_t end = findTag(line, length, start, Schema::kEnd);
+    if (end == std::string::npos) {
+      break;
+    }
+    cells->push_back(Cell {line + start, end - start});
+    start = findTag(line, length, end + sizeof(Schema::kEnd) - 1,
+                    Schema::kStart);
+  }
+}
+
+template <typename Schema>
+bool bf::selectCells(const char* line, std::size_t length,
+                     const std::size_t* columns, std::size_t count,
+                     Cell* cells) {
+  std::size_t last = *std::max_element(columns, columns + count);
+  std::size_t found {0};
+  std::size_t start = findTag(line, length, 0, Schema::kStart);
+  for (std::size_t column = 0; start != std::string::npos && column <= last;
+       ++column) {
+    start += sizeof(Schema::kStart) - 1;
+    std::size_t end = findTag(line, length, start, Schema::kEnd);
+    if (end == std::string::npos) {
+      break;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+      if (columns[i] == column) {
+        cells[i] = Cell {line + start, end - start};
+        ++found;
+      }
+    }
+    start = findTag(line, length, end + sizeof(Schema::kEnd) - 1,
+                    Schema::kStart);
+  }
+  return found == count;
+}
+
+template void bf::splitCells<bf::HtmlSchema>(const char* line,
+                                             std::size_t length,
+                                             std::vector<Cell>* cells);
+template void bf::splitCells<bf::UpperHtmlSchema>(const char* line,
+                                                  std::size_t length,
+                                                  std::vector<Cell>* cells);
+template void bf::splitCells<bf::HeaderSchema>(const char* line,
+                                               std::size_t length,
+                                               std::vector<Cell>* cells);
+template void bf::splitCells<bf::UpperHeaderSchema>(
+    const char* line, std::size_t length, std::vector<Cell>* cells);
+template bool bf::selectCells<bf::HtmlSchema>(const char* line,
+                                              std::size_t length,
+                                              const std::size_t* columns,
+                                              std::size_t count, Cell* cells);
+template bool bf::selectCells<bf::UpperHtmlSchema>(
+    const char* line, std::size_t length, const std::size_t* columns,
+    std::size_t count, Cell* cells);
@@ -0,0 +1,246 @@
+/**
+ *  @file view.cpp
+ *  @brief Selection of the computer groups and rows shown in the output
+ */
+
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Michael Maraya
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <fnmatch.h>
+#include <regex.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bigfix/grouptable.h"
+#include "bigfix/view.h"
+
+namespace {
+
+/**
+ *  @brief Split a comma-separated option argument
+ *  @param list option argument
+ *  @retval std::vector<std::string> non-empty items in order
+ */
+std::vector<std::string> items(const std::string& list) {
+  std::vector<std::string> result;
+  std::size_t start {0};
+  while (start <= list.length()) {
+    std::size_t end = list.find(',', start);
+    if (end == std::string::npos) {
+      end = list.length();
+    }
+    if (end > start) {
+      result.push_back(list.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+  return result;
+}
+
+}  // namespace
+
+bool bf::View::set_groups(const std::string& patterns) {
+  for (const auto& item : items(patterns)) {
+    if (item.length() < 2 || item.front() != '/' || item.back() != '/') {
+      globs_.push_back(item);
+      continue;
+    }
+    std::string expression = item.substr(1, item.length() - 2);
+    regex_t* pattern = new regex_t;
+    if (regcomp(pattern, expression.c_str(), REG_EXTENDED | REG_NOSUB) != 0) {
+      delete pattern;
+      printf("Error: Invalid regular expression %s\n", item.c_str());
+      return false;
+    }
+    patterns_.emplace_back(pattern, [](regex_t* compiled) {
+      regfree(compiled);
+      delete compiled;
+    });
+  }
+  return true;
+}
+
+bool bf::View::set_rows(const std::string& rows) {
+  unsigned selected {0};
+  for (auto item : items(rows)) {
+    std::transform(item.begin(), item.end(), item.begin(), [](char c) {
+      return static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    });
+    if (item == "raw") {
+      selected |= kRawRow;
+    } else if (item == "current") {
+      selected |= kCurrentRow;
+    } else if (item == "target") {
+      selected |= kTargetRow;
+    } else if (item == "comp" || item == "%comp") {
+      selected |= kPercentRow;
+    } else {
+      printf("Error: Unknown row %s\n", item.c_str());
+      return false;
+    }
+  }
+  rows_ = selected;
+  return true;
+}
+
+bool bf::View::set_sort(const std::string& key) {
+  if (key == "percent") {
+    sort_ = SortKey::kPercent;
+  } else if (key == "current") {
+    sort_ = SortKey::kCurrent;
+  } else if (key == "target") {
+    sort_ = SortKey::kTarget;
+  } else if (key == "gap") {
+    sort_ = SortKey::kGap;
+  } else {
+    printf("Error: Unknown sort key %s\n", key.c_str());
+    return false;
+  }
+  return true;
+}
+
+void bf::View::set_top(std::size_t count) {
+  limit_ = count;
+  bottom_ = false;
+}
+
+void bf::View::set_bottom(std::size_t count) {
+  limit_ = count;
+  bottom_ = true;
+}
+
+void bf::View::set_page(std::size_t columns) {
+  page_ = columns;
+}
+
+std::size_t bf::View::page() const {
+  return page_;
+}
+
+void bf::View::set_transposed(bool transposed) {
+  transposed_ = transposed;
+}
+
+bool bf::View::transposed() const {
+  return transposed_;
+}
+
+bool bf::View::shows(Row row) const {
+  return (rows_ & row) != 0;
+}
+
+unsigned bf::View::rows() const {
+  return rows_;
+}
+
+bool bf::View::matches(const std::string& name) const {
+  if ((globs_.empty() && patterns_.empty()) || name == "TOTAL") {
+    return true;
+  }
+  for (const auto& glob : globs_) {
+    if (fnmatch(glob.c_str(), name.c_str(), 0) == 0) {
+      return true;
+    }
+  }
+  for (const auto& pattern : patterns_) {
+    if (regexec(pattern.get(), name.c_str(), 0, nullptr, 0) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ *  @details Each distinct name is matched once, then rows are kept by looking
+ *           up their name identifier, so duplicate rows cost no extra matching.
+ *           When ranking, keys are read straight from the table columns; a
+ *           top or bottom selection uses nth_element() so only the kept
+ *           groups are sorted. Ties keep target file order.
+ */
+std::vector<std::size_t> bf::View::select(GroupTable* table) const {
+  const std::vector<uint32_t>& ids = table->name_ids();
+  const bf::Interner& names = table->names();
+  uint32_t total = names.find("TOTAL");
+  bool filtered = !globs_.empty() || !patterns_.empty();
+  std::vector<bool> shown;
+  if (filtered) {
+    shown.resize(names.size());
+    for (uint32_t id = 0; id < names.size(); ++id) {
+      shown[id] = matches(names.name(id));
+    }
+  }
+  std::vector<std::size_t> rows, totals;
+  rows.reserve(ids.size());
+  for (std::size_t row = 0; row < ids.size(); ++row) {
+    if (ids[row] == total) {
+      totals.push_back(row);
+    } else if (!filtered || shown[ids[row]]) {
+      rows.push_back(row);
+    }
+  }
+  if (sort_ != SortKey::kNone || limit_ > 0) {
+    SortKey key = sort_ != SortKey::kNone ? sort_ : SortKey::kPercent;
+    const uint32_t* current = table->currents().data();
+    const uint32_t* target = table->targets().data();
+    const uint16_t* percent = table->percents().data();
+    std::vector<std::pair<int64_t, std::size_t>> ranks;
+    ranks.reserve(rows.size());
+    for (std::size_t row : rows) {
+      int64_t value {0};
+      switch (key) {
+        case SortKey::kPercent: value = percent[row]; break;
+        case SortKey::kCurrent: value = current[row]; break;
+        case SortKey::kTarget: value = target[row]; break;
+        default:
+          value = static_cast<int64_t>(target[row]) - current[row];
+      }
+      ranks.emplace_back(value, row);
+    }
+    bool bottom = bottom_;
+    auto before = [bottom](const std::pair<int64_t, std::size_t>& a,
+                           const std::pair<int64_t, std::size_t>& b) {
+      if (a.first != b.first) {
+        return bottom ? a.first < b.first : a.first > b.first;
+      }
+      return a.second < b.second;
+    };
+    if (limit_ > 0 && limit_ < ranks.size()) {
+      std::nth_element(ranks.begin(), ranks.begin() + limit_, ranks.end(),
+                       before);
+      ranks.resize(limit_);
+    }
+    std::sort(ranks.begin(), ranks.end(), before);
+    rows.clear();
+    for (const auto& rank : ranks) {
+      rows.push_back(rank.second);
+    }
+  }
+  rows.insert(rows.end(), totals.begin(), totals.end());
+  return rows;
+}
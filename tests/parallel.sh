@@ -0,0 +1,87 @@
+#!/bin/sh
+# 
+#  The MIT License (MIT)
+# 
+#  Copyright (c) 2014 Michael Maraya
+# 
+#  Permission is hereby granted, free of charge, to any person obtaining a copy
+#  of this software and associated documentation files (the "Software"), to deal
+#  in the Software without restriction, including without limitation the rights
+#  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+#  copies of the Software, and to permit persons to whom the Software is
+#  furnished to do so, subject to the following conditions:
+# 
+#  The above copyright notice and this permission notice shall be included in
+#  all copies or substantial portions of the Software.
+# 
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+#  SOFTWARE.
+# 
+
+# Run the corpus in tests/corpus with 1 to N worker threads and fail if any
+# output differs from the single-threaded one.
+# usage: parallel.sh program corpus threads
+
+program=$1
+corpus=$2
+threads=$3
+work=$(mktemp -d) || exit 1
+trap 'rm -rf "$work"' EXIT
+
+targets=$corpus/targets.csv
+reports="$corpus/reports/a20141020.html $corpus/reports/b20141021.html.gz
+         $corpus/reports/c20141022.csv $corpus/reports/d20141023.xml"
+exports="$corpus/e1_20141020.html $corpus/e2_20141020.html
+         $corpus/e3_20141020.html"
+
+# write every output of one thread count into its own directory
+outputs() {
+  n=$1
+  out=$work/$n
+  mkdir "$out"
+  c=""
+  for f in $reports; do c="$c -c $f"; done
+  e=""
+  for f in $exports; do e="$e -e $f"; done
+  "$program" -j "$n" -t "$targets" $c --sources --join > "$out/reports"
+  "$program" -j "$n" -t "$targets" -b "$corpus/reports" > "$out/batch"
+  "$program" -j "$n" -t "$targets" $e --join \
+      --count '"Windows-Servers"&OS|Lab' > "$out/exports"
+  "$program" -j "$n" -t "$targets" $e --approx --count 'OS|Lab' > "$out/approx"
+  "$program" -j "$n" -t "$targets" $e --max-memory 4K > "$out/spill"
+  "$program" -j "$n" -t "$targets" $e > "$out/distinct"
+  # split each kind of input over two partials and merge them back
+  set -- $reports
+  "$program" -j "$n" -c "$1" -c "$2" --emit-partial "$out/r1.bfp" > /dev/null
+  "$program" -j "$n" -c "$3" -c "$4" --emit-partial "$out/r2.bfp" > /dev/null
+  set -- $exports
+  "$program" -j "$n" -e "$1" -e "$2" --emit-partial "$out/e1.bfp" > /dev/null
+  "$program" -j "$n" -e "$3" --emit-partial "$out/e2.bfp" > /dev/null
+  "$program" -j "$n" -t "$targets" --merge "$out/r1.bfp" "$out/r2.bfp" \
+      > "$out/merge-reports"
+  "$program" -j "$n" -t "$targets" --merge "$out/e1.bfp" "$out/e2.bfp" \
+      > "$out/merge-exports"
+  # merged memberships must give exactly the counts of one run over all
+  # the exports, so an export left out of the merge is caught
+  if ! cmp -s "$out/distinct" "$out/merge-exports"; then
+    echo "parallel: merged endpoint partials differ from -e with -j $n"
+    diff "$out/distinct" "$out/merge-exports"
+    exit 1
+  fi
+}
+
+j=1
+while [ "$j" -le "$threads" ]; do
+  outputs "$j"
+  if [ "$j" -gt 1 ] && ! diff -r "$work/1" "$work/$j"; then
+    echo "parallel: output with -j $j differs from -j 1"
+    exit 1
+  fi
+  j=$((j + 1))
+done
+echo "parallel: -j 1 to -j $threads give identical output"